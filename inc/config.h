@@ -32,8 +32,15 @@ struct game_config {
     int font_size;
 #endif
     char *userdir;
+    char *compression;     /* codec for saved games: "gzip" or "none" */
+    int compression_level; /* 1 (fast) to 9 (best), 0 if not set */
     gboolean show_scores;
     gboolean show_version;
+    char *export_save; /* write the saved game as JSON to this file */
+    char *import_save; /* convert this file into the saved game */
+    int bench_save;    /* time saving and loading this many times */
+    int bench_paths;   /* number of random maps to test path finding on */
+    int bench_fov;     /* time calculating the fov of every position this often */
 };
 
 /* configuration file reading and writing */
@@ -56,6 +63,22 @@ char *compose_autopickup_settings(const gboolean config[IT_MAX]);
  */
 char *verbose_autopickup_settings(const gboolean config[IT_MAX]);
 
+/* the compression level used if none or an invalid one has been set */
+#define COMPRESSION_LEVEL_DEFAULT 6
+
+/**
+ * @brief Determine the zlib compression level to use for saved games
+ *        and the scoreboard.
+ *
+ * Unknown codecs and levels outside of 1 to 9 are reported on stderr
+ * and replaced by gzip and COMPRESSION_LEVEL_DEFAULT.
+ *
+ * @param the configuration
+ * @return 0 for uncompressed files, otherwise a zlib compression level
+ *         from 1 to 9
+ */
+int parse_compression(struct game_config *config);
+
 int parse_gender(const char gender);
 char compose_gender(const int gender);
 
@@ -146,7 +146,16 @@ effect *effect_copy(effect *e);
 void effect_destroy(effect *e);
 
 void effect_serialize(gpointer oid, effect *e, cJSON *root);
-effect *effect_deserialize(cJSON *eser, struct game *g);
+
+/**
+ * @brief Restore an effect from a saved game.
+ *
+ * The effect is not added to the game; this is left to the caller.
+ *
+ * @param the serialized effect
+ * @return the restored effect
+ */
+effect *effect_deserialize(cJSON *eser);
 cJSON *effects_serialize(GPtrArray *effs);
 GPtrArray *effects_deserialize(cJSON *eser);
 
@@ -38,6 +38,9 @@ typedef struct _fov fov;
 fov *fov_new();
 
 /** @brief calculate the FOV for a map
+  *
+  * If neither the position nor the map have changed since the last call,
+  * the previous FOV is kept and only the visible monsters are updated.
   *
   * @param pointer to a fov structure.
   * @param the map
@@ -61,11 +64,20 @@ gboolean fov_get(fov *fv, position pos);
   * @param pointer to a fov structure.
   * @param a position.
   * @param the visibility of the position.
+  * @param Check for monsters at the position in fov_find_monsters()?
+  */
+void fov_set(fov *fv, position pos, guchar visible, gboolean mchk);
+
+/** @brief Collect the visible monsters after setting the visible positions.
+  *
+  * fov_calculate() does this by itself; it is required after setting
+  * the positions with fov_set().
+  *
+  * @param pointer to a fov structure.
+  * @param the map
   * @param Beholder has infravision?
-  * @param Check for monsters at the position?
   */
-void fov_set(fov *fv, position pos, guchar visible,
-             gboolean infravision, gboolean mchk);
+void fov_find_monsters(fov *fv, map *m, gboolean infravision);
 
 /** @brief reset visibility for an entire fov structure.
   *
@@ -83,9 +95,29 @@ monster *fov_get_closest_monster(fov *fv);
 /** @brief Get a list of all visible monsters
   *
   * @param A pointer to a fov structure
-  * @return A GList with all visible monsters, sorted by proximity, or NULL
+  * @return An array of all visible monsters, sorted by proximity. It
+  *         belongs to the fov and is valid until the fov changes.
+  */
+GPtrArray *fov_get_visible_monsters(fov *fv);
+
+/** @brief Get all visible positions.
+  *
+  * @param A pointer to a fov structure
+  * @return An array of positions that belongs to the fov.
+  */
+GArray *fov_get_visible(fov *fv);
+
+/** @brief Get the positions that have become visible with the last
+  *        call of fov_calculate().
+  *
+  * The previous fov can only be compared if it has been calculated for
+  * the same map and the map has not changed in between.
+  *
+  * @param A pointer to a fov structure
+  * @return An array of positions that belongs to the fov, or NULL if the
+  *         previous fov could not be compared.
   */
-GList *fov_get_visible_monsters(fov *fv);
+GArray *fov_get_gained(fov *fv);
 
 /** @brief destroy fov data
   *
@@ -94,4 +126,15 @@ GList *fov_get_visible_monsters(fov *fv);
   */
 void fov_free(fov *fv);
 
+/** @brief Time and verify the fov calculation.
+  *
+  * The fov of every position of every maze is compared to the one of the
+  * original floating point implementation. The fovs of the player in the
+  * town and of monsters in the dungeon are timed for both.
+  *
+  * @param The number of times the fovs of all positions are calculated.
+  * @return FALSE if any fov differs from the original one.
+  */
+gboolean fov_benchmark(int runs);
+
 #endif
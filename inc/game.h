@@ -96,6 +96,10 @@ typedef struct game
     /* spheres do not need to be referenced, thus a pointer array is sufficient */
     GPtrArray *spheres;
 
+    /* zlib compression level for saved games and the scoreboard,
+       0 for uncompressed files */
+    int compression;
+
     /* flags */
     guint32
         player_stats_set: 1, /* the player's stats have been assigned */
@@ -132,6 +136,17 @@ const gchar *game_userdir();
  */
 int game_save(game *g);
 
+/**
+ * @brief Save a game without waiting for the file to be written.
+ *
+ * The game is serialized immediately; compressing and writing the
+ * data happens in a separate thread. Pending saves are completed by
+ * the next call to game_save() or game_destroy().
+ *
+ * @param The game to save
+ */
+void game_save_background(game *g);
+
 map *game_map(game *g, guint nmap);
 void game_spin_the_wheel(game *g);
 void game_remove_dead_monsters(game *g);
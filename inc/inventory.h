@@ -22,6 +22,7 @@
 #include <glib.h>
 
 #include "items.h"
+#include "savefile.h"
 
 /* forward declarations */
 struct _inventory;
@@ -47,6 +48,24 @@ void inv_destroy(inventory *inv, gboolean special);
 cJSON *inv_serialize(inventory *inv);
 inventory *inv_deserialize(cJSON *iser);
 
+/**
+ * Write the oids of all items in an inventory to a binary buffer.
+ * The count of items has to be stored by the caller.
+ *
+ * @param the inventory (may be NULL)
+ * @param the buffer to append to
+ */
+void inv_serialize_oids(inventory *inv, GByteArray *buf);
+
+/**
+ * Restore an inventory from a list of oids written by inv_serialize_oids().
+ *
+ * @param the reader positioned at the first oid
+ * @param the count of oids to read
+ * @return a new inventory
+ */
+inventory *inv_deserialize_oids(savefile_reader *r, guint count);
+
 void inv_callbacks_set(inventory *inv, inv_callback_bool pre_add,
                        inv_callback_void post_add, inv_callback_bool pre_del,
                        inv_callback_void post_del);
@@ -135,7 +135,17 @@ item *item_split(item *original, guint32 count);
 void item_destroy(item *it);
 
 void item_serialize(gpointer oid, gpointer it, gpointer root);
-item *item_deserialize(cJSON *iser, struct game *g);
+
+/**
+ * @brief Restore an item from a saved game.
+ *
+ * The item is not added to the game; this is left to the caller, which
+ * allows to decode several items concurrently.
+ *
+ * @param the serialized item
+ * @return the restored item
+ */
+item *item_deserialize(cJSON *iser);
 
 /**
  * Compare two items.
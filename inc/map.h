@@ -23,6 +23,7 @@
 #include "items.h"
 #include "monsters.h"
 #include "position.h"
+#include "savefile.h"
 #include "sobjects.h"
 #include "traps.h"
 #include "utils.h"
@@ -32,6 +33,9 @@
 #define MAP_MAX_Y 17
 #define MAP_SIZE MAP_MAX_X*MAP_MAX_Y
 
+/* number of 64 bit words needed to store a bit for every tile of a row */
+#define MAP_ROW_WORDS ((MAP_MAX_X + 63) / 64)
+
 /* number of levels */
 #define MAP_DMAX 11                   /* max # levels in the dungeon */
 #define MAP_VMAX  3                   /* max # of levels in the temple of the luran */
@@ -99,9 +103,25 @@ typedef struct map
     guint32 nlevel;                       /* map number */
     guint32 visited;                      /* last time player has been on this map */
     guint32 mcount;                       /* monster count */
+    guint32 revision;                     /* changes of tile types and stationary objects */
     map_tile grid[MAP_MAX_Y][MAP_MAX_X];  /* the map */
+    guint64 transparent[MAP_MAX_Y][MAP_ROW_WORDS]; /* one bit per see-through tile */
+    struct map_dmap *dmaps[LE_MAX];       /* distances to the player per map element */
+    struct map_dmap *safety[LE_MAX];      /* safety maps for fleeing per map element */
+    struct map_exits *exits[LE_MAX];      /* costs between the map exits per map element */
+    struct map_areas *areas[LE_MAX];      /* connected areas per map element */
+    struct map_los *los;                  /* lines of sight to the player */
+    GArray *moves;                        /* positions monsters entered or left since map_find_paths() */
 } map;
 
+/* search state of path elements */
+typedef enum map_path_state
+{
+    MAP_PATH_NEW,    /* not yet reached */
+    MAP_PATH_OPEN,   /* reached, waiting to be examined */
+    MAP_PATH_CLOSED  /* examined */
+} map_path_state;
+
 /* Structure for path elements */
 typedef struct map_path_element
 {
@@ -109,17 +129,50 @@ typedef struct map_path_element
     guint32 g_score;
     guint32 h_score;
     struct map_path_element* parent;
+    guint32 open_idx;   /* index in the open list while the element is open */
+    guint32 search;     /* the search the element has last been used by */
+    guint8 state;       /* not yet seen, open or closed */
 } map_path_element;
 
 typedef struct map_path
 {
-    GQueue *path;
-    GPtrArray *closed;
-    GPtrArray *open;
+    GQueue *path;             /* the steps, owned by the path */
+    map_path_element *nodes;  /* search state of every position of the map */
+    map_path_element **open;  /* binary heap of elements to be examined */
+    guint open_len;
+    guint32 search;           /* number of the current search */
     position start;
     position goal;
 } map_path;
 
+/* a path query of a batch solved by map_find_paths() */
+typedef struct map_path_query
+{
+    position start;
+    position goal;
+    map_element_t element;
+    position step;          /* result: the first step of the path */
+    gint32 cost;            /* result: the cost of the path */
+    guint32 revision;       /* result: the revision of the map at that time */
+} map_path_query;
+
+/* a step of a route and the state of its tile when it has been planned */
+typedef struct map_route_step
+{
+    position pos;
+    map_tile_t type;
+    trap_t trap;
+} map_route_step;
+
+/* a path that is followed over several turns, e.g. when travelling */
+typedef struct map_route
+{
+    GArray *steps;          /* the remaining steps, the next one is last */
+    position goal;
+    position last;          /* where the traveller is expected to be */
+    map_element_t element;
+} map_route;
+
 /* callback function for trajectories */
 typedef gboolean (*trajectory_hit_sth)(const GList *trajectory,
         const damage_originator *damo,
@@ -128,10 +181,40 @@ typedef gboolean (*trajectory_hit_sth)(const GList *trajectory,
 /* function declarations */
 
 map *map_new(int num, char *mazefile);
+
+/**
+ * @brief Create a map from one of the mazes of the maze file.
+ *
+ * Unlike map_new(), only monsters are added to the maze. This is meant
+ * for checking algorithms on every maze.
+ *
+ * @param the number of the map
+ * @param the maze file
+ * @param the number of the maze in the file
+ * @return the new map or NULL if the maze could not be loaded
+ */
+map *map_new_maze(int num, char *mazefile, guint which);
 void map_destroy(map *m);
 
 cJSON *map_serialize(map *m);
 map *map_deserialize(cJSON *mser);
+
+/**
+ * @brief Append a map to a binary saved game.
+ *
+ * @param the map
+ * @param the buffer to append to
+ */
+void map_serialize_binary(map *m, GByteArray *buf);
+
+/**
+ * @brief Restore a map from a binary saved game.
+ *
+ * @param the reader positioned at the start of the map
+ * @return the restored map or NULL if the data was incomplete
+ */
+map *map_deserialize_binary(savefile_reader *r);
+
 char *map_dump(map *m, position ppos);
 
 position map_find_space(map *m, map_element_t element,
@@ -163,9 +246,32 @@ int *map_get_surrounding(map *m, position pos, sobject_t type);
  */
 int map_pos_is_visible(map *m, position source, position target);
 
+/**
+ * @brief Determine if a position can be seen from another position,
+ *        remembering the result.
+ *
+ * The results are kept for a single target until it moves or the map
+ * changes; this is meant for many sources looking at the same target,
+ * e.g. the monsters looking for the player.
+ *
+ * @param the map
+ * @param first position
+ * @param second position
+ * @return TRUE or FALSE, like map_pos_is_visible()
+ */
+int map_pos_is_visible_cached(map *m, position source, position target);
+
 /**
  * @brief Find a path between two positions
  *
+ * The steps of the path are stored in the memory used for the search and
+ * must not be removed from the queue; use g_queue_peek_head() and the like.
+ *
+ * If the destination is on another map, the way is planned across the map
+ * exits and the returned path leads to the exit that has to be taken on
+ * the starting map. The path is empty if the start is that exit. Paths
+ * for the player only lead through maps the player has visited before.
+ *
  * @param the map to work on
  * @param the starting position
  * @param the destination
@@ -176,12 +282,142 @@ map_path *map_find_path(map *m, position start, position goal,
                         map_element_t element);
 
 /**
- * @brief Free memory allocated for a given map path.
+ * @brief Enable or disable jump point search.
+ *
+ * When enabled, map_find_path() uses jump point search instead of A* if
+ * every position the traveller can enter costs the same. Jump point
+ * search skips the symmetric alternatives of open areas. Diagonal steps
+ * cost as much as straight ones, as they do for A*, thus the paths found
+ * take as few steps as the ones found by A*, though they may differ.
+ *
+ * @param TRUE to enable jump point search, which is the default
+ */
+void map_path_jps_set(gboolean enable);
+
+/**
+ * @brief Release a path for the next search.
  *
  * @param a map path returned by <map_find_path>"()"
  */
 void map_path_destroy(map_path *path);
 
+/**
+ * @brief Find the first steps of several paths on the same map at once.
+ *
+ * Queries sharing a goal and map element are answered by a single search
+ * spreading from the goal; large batches are spread over several threads.
+ * No random numbers are used and the map is not changed, thus the results
+ * do not depend on the order of the queries. The starts have to be on the
+ * given map, goals on other maps are planned across the map exits.
+ *
+ * @param the map to work on
+ * @param the queries; the step of each is set to the first position of the
+ *        way to the goal, to the start if the way on this map ends there or
+ *        to pos_invalid if no way could be found
+ * @param the number of queries
+ */
+void map_find_paths(map *m, map_path_query *queries, guint count);
+
+/**
+ * @brief Check if the way found by <map_find_paths>"()" is still the
+ *        cheapest one.
+ *
+ * The way may have become more expensive or a cheaper one may have been
+ * cleared if the map has changed or monsters have entered or left
+ * positions close enough to the way since the search.
+ *
+ * @param the map the query has been answered for
+ * @param the answered query
+ * @return TRUE if searching again would find a way of the same cost
+ */
+gboolean map_path_query_current(map *m, map_path_query *q);
+
+/**
+ * @brief Time and verify the path finding algorithms.
+ *
+ * Random queries are run on every maze of the maze file and on randomly
+ * generated maps. The paths found are compared to the cheapest ways
+ * determined by a plain relaxation of the step costs.
+ *
+ * @param the number of random maps
+ * @return FALSE if any path was wrong
+ */
+gboolean map_benchmark_paths(int maps);
+
+/**
+ * @brief Create a new route.
+ *
+ * The route is planned when the first step is requested.
+ *
+ * @param the destination
+ * @param the map_element_t that travels
+ * @return a new route
+ */
+map_route *map_route_new(position goal, map_element_t element);
+
+/**
+ * @brief Get the next step of a route.
+ *
+ * The remaining steps are kept between the calls. They are only searched
+ * again where the tiles along the route have changed - as known by the
+ * player when the route is followed by the player - or if a monster
+ * blocks the next step. The whole route is planned again if the
+ * traveller has not arrived where the last call lead to.
+ *
+ * @param the route
+ * @param the map the traveller is on
+ * @param the position of the traveller
+ * @return the next position, the current position if the end of the route
+ *         on the current map has been reached or pos_invalid if the
+ *         destination cannot be reached
+ */
+position map_route_next(map_route *route, map *m, position pos);
+
+void map_route_destroy(map_route *route);
+
+/**
+ * @brief Determine if a position can be entered by a map element.
+ *
+ * Only the tile and the stationary object on it are taken into account.
+ *
+ * @param the map
+ * @param the position
+ * @param the map_element_t that wants to enter the position
+ * @return TRUE if the position can be entered
+ */
+gboolean map_pos_passable_by(map *m, position pos, map_element_t element);
+
+/**
+ * @brief Find the next step towards the player.
+ *
+ * The distances of all positions of the map to the player are determined
+ * once and shared by all monsters of the same kind of movement until the
+ * player moves or the map changes.
+ *
+ * @param the map the player is on
+ * @param the position to move from
+ * @param the map_element_t that moves
+ * @return the next position or pos_invalid if there is no free
+ *         position closer to the player
+ */
+position map_step_to_player(map *m, position pos, map_element_t element);
+
+/**
+ * @brief Find the next step away from the player.
+ *
+ * The safety map used for this is derived from the distances to the
+ * player: they are inverted and spread again, thus positions far from
+ * the player with an escape route are preferred over dead ends close
+ * by. Like the distances, it is shared by all monsters that flee.
+ *
+ * @param the map the player is on
+ * @param the position to move from
+ * @param the map_element_t that moves
+ * @return the next position, the current position if there is no safer
+ *         one around or pos_invalid if all safer positions are occupied
+ */
+position map_step_from_player(map *m, position pos, map_element_t element);
+
 /**
  * Return a linked list with every position between two points.
  *
@@ -242,6 +478,25 @@ void map_fill_with_life(map *m);
 
 gboolean map_is_exit_at(map *m, position pos);
 
+/**
+ * @brief Determine where a map exit leads to.
+ *
+ * @param a map
+ * @param the position of the exit
+ * @return the position on the other map or pos_invalid if there is no exit
+ */
+position map_exit_target(map *m, position pos);
+
+/**
+ * @brief Record a change of the tile type or the stationary object of a tile.
+ *
+ * This has to be called after modifying the grid directly.
+ *
+ * @param a map
+ * @param the position of the modified tile
+ */
+void map_tile_changed(map *m, position pos);
+
 /**
  * Process temporary effects for a map.
  *
@@ -288,6 +543,7 @@ static inline void map_tiletype_set(map *m, position pos, map_tile_t type)
 {
     g_assert(m != NULL && pos_valid(pos));
     m->grid[Y(pos)][X(pos)].type = type;
+    map_tile_changed(m, pos);
 }
 
 static inline map_tile_t map_basetype_at(map *m, position pos)
@@ -330,12 +586,16 @@ static inline void map_sobject_set(map *m, position pos, sobject_t type)
 {
     g_assert(m != NULL && pos_valid(pos));
     m->grid[Y(pos)][X(pos)].sobject = type;
+    map_tile_changed(m, pos);
 }
 
 static inline void map_set_monster_at(map *m, position pos, monster *monst)
 {
     g_assert(m != NULL && m->nlevel == Z(pos) && pos_valid(pos));
     m->grid[Y(pos)][X(pos)].m_oid = (monst != NULL) ? monster_oid(monst) : NULL;
+
+    if (m->moves != NULL)
+        g_array_append_val(m->moves, pos);
 }
 
 static inline gboolean map_is_monster_at(map *m, position pos)
@@ -374,10 +634,14 @@ static inline const char *map_name(map *m)
     return map_names[m->nlevel];
 }
 
+static inline gboolean map_xy_transparent(map *m, int x, int y)
+{
+    return (m->transparent[y][x >> 6] >> (x & 63)) & 1;
+}
+
 static inline gboolean map_pos_transparent(map *m, position pos)
 {
-    return mt_is_transparent(m->grid[Y(pos)][X(pos)].type)
-        && so_is_transparent(m->grid[Y(pos)][X(pos)].sobject);
+    return map_xy_transparent(m, X(pos), Y(pos));
 }
 
 static inline gboolean map_pos_passable(map *m, position pos)
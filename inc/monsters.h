@@ -169,7 +169,17 @@ monster *monster_new_by_level(position pos);
 void monster_destroy(monster *m);
 
 void monster_serialize(gpointer oid, monster *m, cJSON *root);
-void monster_deserialize(cJSON *mser, struct game *g);
+
+/**
+ * @brief Restore a monster from a saved game.
+ *
+ * The monster is neither added to the game nor counted on its map; this
+ * is left to the caller. The items of the game have to be restored before.
+ *
+ * @param the serialized monster
+ * @return the restored monster
+ */
+monster *monster_deserialize(cJSON *mser);
 
 /* getters / setters */
 
@@ -209,6 +219,17 @@ void monster_die(monster *m, struct player *p);
 void monster_level_enter(monster *m, struct map *l);
 void monster_move(gpointer *oid, monster *m, struct game *g);
 
+/**
+ * @brief Plan the ways of the monsters on the player's map.
+ *
+ * The ways of all monsters that are going to follow a path this turn are
+ * searched at once; monster_move() uses the first steps found if they are
+ * still free when the monster moves.
+ *
+ * @param the game
+ */
+void monster_plan_paths(struct game *g);
+
 void monster_polymorph(monster *m);
 
 /**
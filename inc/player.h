@@ -224,9 +224,37 @@ char player_select_bonus_stats();
 gboolean player_assign_bonus_stats(player *p, char preset);
 void player_destroy(player *p);
 
-cJSON *player_serialize(player *p);
+/**
+ * @brief Serialize the player.
+ *
+ * @param the player
+ * @param TRUE to include the player's memory of the maps
+ * @return the serialized player
+ */
+cJSON *player_serialize(player *p, gboolean memory);
 player *player_deserialize(cJSON *pser);
 
+/**
+ * @brief Append the player's memory of a map to a binary saved game.
+ *
+ * @param the player
+ * @param the number of the map
+ * @param the buffer to append to
+ */
+void player_memory_serialize_binary(player *p, int nmap, GByteArray *buf);
+
+/**
+ * @brief Restore the player's memory of a map from a binary saved game.
+ *
+ * @param the player
+ * @param the number of the map
+ * @param the reader positioned at the start of the memory
+ * @param the format revision of the saved game
+ * @return FALSE if the data was incomplete
+ */
+gboolean player_memory_deserialize_binary(player *p, int nmap,
+                                          savefile_reader *r, guint format);
+
 /**
  * @brief consume time for an action by the player
  *
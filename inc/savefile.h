@@ -0,0 +1,193 @@
+/*
+ * savefile.h
+ * Copyright (C) 2009-2018 Joachim de Groot <jdegroot@web.de>
+ *
+ * NLarn is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NLarn is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __SAVEFILE_H_
+#define __SAVEFILE_H_
+
+#include <glib.h>
+#include <zlib.h>
+
+/*
+ * Binary saved games start with the magic bytes, followed by the format
+ * revision. The rest of the file is a sequence of sections, each of them
+ * consisting of a one byte section type, the length of the payload as
+ * 32 bit value, the CRC32 of the payload and the payload itself. All
+ * values are stored little-endian.
+ *
+ * The file is written as a series of concatenated gzip members which
+ * zlib reads as a single stream. This allows to keep the compressed
+ * data of sections that have not changed since the last save. When
+ * compression is disabled, the sections are written as they are; zlib
+ * detects this from the missing gzip header and reads such files
+ * transparently.
+ */
+#define SAVEFILE_MAGIC     "NLSV"
+#define SAVEFILE_MAGIC_LEN 4
+
+/* revision of the binary container layout:
+   1: the player's memory of all maps in a single section
+   2: one memory section per map
+   3: run-length encoded memory planes
+   4: checksum of the payload in every section header */
+#define SAVEFILE_FORMAT    4
+
+/* size of the file header and of a section header */
+#define SAVEFILE_HEADER_LEN  (SAVEFILE_MAGIC_LEN + 1)
+#define SAVEFILE_SECTION_LEN 9
+
+/* size of a section header up to revision 3, which had no checksum */
+#define SAVEFILE_SECTION_LEN_3 5
+
+/* upper limit for the payload of a single section; anything bigger
+   is regarded as a corrupted file */
+#define SAVEFILE_SECTION_MAX (64 * 1024 * 1024)
+
+typedef enum _savefile_section
+{
+    SFS_END,    /* marks the end of the saved game */
+    SFS_GAME,   /* compact JSON document with the remaining game data */
+    SFS_MAP,    /* fixed-width tile records and oid table of one map */
+    SFS_MEMORY, /* the player's memory of all maps */
+    SFS_MAX
+} savefile_section;
+
+/* cursor used to read values from a binary buffer */
+typedef struct _savefile_reader
+{
+    const guint8 *data;
+    gsize len;
+    gsize pos;
+    gboolean error; /* set when trying to read beyond the end of data */
+} savefile_reader;
+
+/* incremental reader for saved games: only the payload of the section
+   currently being restored is kept in memory */
+typedef struct _savefile_stream
+{
+    gzFile file;
+    GByteArray *buf;
+    guint8 format;  /* format revision of the saved game */
+} savefile_stream;
+
+/* writing */
+void sf_put_u8(GByteArray *buf, guint8 val);
+void sf_put_u16(GByteArray *buf, guint16 val);
+void sf_put_u32(GByteArray *buf, guint32 val);
+void sf_put_data(GByteArray *buf, gconstpointer data, gsize len);
+
+/**
+ * @brief Write the header of a binary saved game.
+ *
+ * @param the buffer to write to
+ */
+void sf_put_header(GByteArray *buf);
+
+/**
+ * @brief Start a new section.
+ *
+ * @param the buffer to write to
+ * @param the type of the section
+ * @return the offset of the section's length field, to be passed to
+ *         sf_section_end() once the payload has been written
+ */
+guint sf_section_begin(GByteArray *buf, savefile_section type);
+
+/**
+ * @brief Finish a section by recording the size and the checksum of
+ *        its payload.
+ *
+ * @param the buffer written to
+ * @param the offset returned by sf_section_begin()
+ */
+void sf_section_end(GByteArray *buf, guint offset);
+
+/**
+ * @brief Append a run-length encoded sequence of values.
+ *
+ * Every run is stored as 16 bit run length followed by the value.
+ *
+ * @param the buffer to write to
+ * @param the values
+ * @param the number of values
+ * @param the number of bytes used to store each value (1 or 4)
+ */
+void sf_put_rle(GByteArray *buf, const guint32 *values, guint count,
+                guint width);
+
+/**
+ * @brief Compress data into a self-contained gzip member.
+ *
+ * @param the data to compress
+ * @param the length of the data
+ * @param the zlib compression level; 0 returns an uncompressed copy
+ * @return a freshly allocated buffer or NULL on failure
+ */
+GByteArray *sf_compress(const guint8 *data, gsize len, int level);
+
+/* reading */
+void sf_reader_init(savefile_reader *r, gconstpointer data, gsize len);
+guint8 sf_get_u8(savefile_reader *r);
+guint16 sf_get_u16(savefile_reader *r);
+guint32 sf_get_u32(savefile_reader *r);
+
+/**
+ * @brief Read a sequence of values written by sf_put_rle().
+ *
+ * @param the reader
+ * @param the buffer for the decoded values
+ * @param the number of values expected
+ * @param the number of bytes used to store each value (1 or 4)
+ * @return FALSE if the data was incomplete or did not match the count
+ */
+gboolean sf_get_rle(savefile_reader *r, guint32 *values, guint count,
+                    guint width);
+
+/**
+ * @brief Get a pointer to the next bytes of the buffer and skip them.
+ *
+ * @param the reader
+ * @param the number of bytes
+ * @return a pointer into the buffer or NULL if less data is available
+ */
+const guint8 *sf_get_data(savefile_reader *r, gsize len);
+
+/**
+ * @brief Check if a buffer starts with the header of a binary saved game.
+ *
+ * @param the buffer
+ * @param the length of the buffer
+ * @return TRUE if the buffer holds a binary saved game
+ */
+gboolean sf_is_binary(gconstpointer data, gsize len);
+
+/**
+ * @brief Read the next section of a binary saved game.
+ *
+ * The returned section stays valid until the next section is read. The
+ * payload is checked against the checksum of the section header before
+ * it is returned.
+ *
+ * @param the stream to read from
+ * @param the expected section type
+ * @param a reader that is set up to point to the section's payload
+ * @return FALSE if the section is of another type, incomplete or corrupted
+ */
+gboolean sf_stream_section(savefile_stream *s, savefile_section type,
+                           savefile_reader *section);
+
+#endif
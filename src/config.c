@@ -66,7 +66,13 @@ static const char *default_config_file =
 #endif
     "# Disable automatic saving when switching a level. Saving the game is\n"
     "# enabled by default, disable when it's too slow on your computer\n"
-    "no-autosave=false\n";
+    "no-autosave=false\n"
+    "\n"
+    "# Compression of saved games and the scoreboard (gzip/none)\n"
+    "compression=gzip\n"
+    "\n"
+    "# Compression level from 1 (fastest) to 9 (smallest files)\n"
+    "compression-level=6\n";
 
 /* parse the command line */
 void parse_commandline(int argc, char *argv[], struct game_config *config)
@@ -86,6 +92,13 @@ void parse_commandline(int argc, char *argv[], struct game_config *config)
         { "userdir",     'D', 0, G_OPTION_ARG_FILENAME, &config->userdir,    "Alternate directory for config file and saved games", NULL },
         { "highscores",  'h', 0, G_OPTION_ARG_NONE,   &config->show_scores,  "Show highscores and exit", NULL },
         { "version",     'v', 0, G_OPTION_ARG_NONE,   &config->show_version, "Show version information and exit", NULL },
+        { "compression", 0,   0, G_OPTION_ARG_STRING, &config->compression,  "Compression of saved games and the scoreboard (gzip/none)", "CODEC" },
+        { "compression-level", 0, 0, G_OPTION_ARG_INT, &config->compression_level, "Compression level from 1 (fastest) to 9 (smallest files)", "N" },
+        { "export-save", 0,   0, G_OPTION_ARG_FILENAME, &config->export_save, "Write the saved game as JSON to FILE and exit", "FILE" },
+        { "import-save", 0,   0, G_OPTION_ARG_FILENAME, &config->import_save, "Convert the saved game in FILE to the current format and exit", "FILE" },
+        { "bench-save",  0,   0, G_OPTION_ARG_INT,    &config->bench_save,   "Time saving and loading synthetic games N times each and exit", "N" },
+        { "bench-paths", 0,   0, G_OPTION_ARG_INT,    &config->bench_paths,  "Time and verify path finding on the mazes and N random maps and exit", "N" },
+        { "bench-fov",   0,   0, G_OPTION_ARG_INT,    &config->bench_fov,    "Time and verify the fov of every position of the mazes N times and exit", "N" },
         { NULL, 0, 0, 0, NULL, NULL, NULL }
     };
 
@@ -146,6 +159,14 @@ gboolean parse_ini_file(const char *filename, struct game_config *config)
         if (!config->font_size && !error) config->font_size = font_size;
         g_clear_error(&error);
 #endif
+
+        char *compression = g_key_file_get_string(ini_file, "nlarn", "compression", &error);
+        if (!config->compression && !error) config->compression = compression;
+        g_clear_error(&error);
+
+        int compression_level = g_key_file_get_integer(ini_file, "nlarn", "compression-level", &error);
+        if (!config->compression_level && !error) config->compression_level = compression_level;
+        g_clear_error(&error);
     }
     else
     {
@@ -178,6 +199,11 @@ void write_ini_file(const char *filename, struct game_config *config)
 #ifdef SDLPDCURSES
         g_key_file_set_integer(kf, "nlarn", "font-size", config->font_size);
 #endif
+        if (config->compression)
+            g_key_file_set_value(kf, "nlarn", "compression", config->compression);
+
+        if (config->compression_level)
+            g_key_file_set_integer(kf, "nlarn", "compression-level", config->compression_level);
     }
 
     /* write config file contents to the give file */
@@ -243,6 +269,28 @@ char *verbose_autopickup_settings(const gboolean config[IT_MAX])
     return g_string_free(settings, settings->len == 0);
 }
 
+int parse_compression(struct game_config *config)
+{
+    if (config->compression && g_ascii_strcasecmp(config->compression, "none") == 0)
+        return 0;
+
+    if (config->compression && g_ascii_strcasecmp(config->compression, "gzip") != 0)
+        g_printerr("Unknown compression \"%s\", using gzip.\n", config->compression);
+
+    if (config->compression_level == 0)
+        return COMPRESSION_LEVEL_DEFAULT;
+
+    if (config->compression_level < 1 || config->compression_level > 9)
+    {
+        g_printerr("Invalid compression level %d, using %d.\n",
+                   config->compression_level, COMPRESSION_LEVEL_DEFAULT);
+
+        return COMPRESSION_LEVEL_DEFAULT;
+    }
+
+    return config->compression_level;
+}
+
 int parse_gender(const char gender)
 {
     char _gender = g_ascii_tolower(gender);
@@ -2282,8 +2282,9 @@ position display_get_new_position(player *p,
     int attrs; /* curses attributes */
     display_window *msgpop = NULL;
 
-    /* list of visible monsters and the iterator for these */
-    GList *mlist = NULL, *miter = NULL;
+    /* list of visible monsters and the index of the selected one */
+    GPtrArray *mlist = NULL;
+    guint midx = 0;
 
     /* variables for ray or ball painting */
     area *b = NULL;       /* a ball area */
@@ -2301,7 +2302,7 @@ position display_get_new_position(player *p,
 
     /* get the list of visible monsters if looking for a visible position */
     if (visible)
-        miter = mlist = fov_get_visible_monsters(p->fv);
+        mlist = fov_get_visible_monsters(p->fv);
 
     if (!visible)
         msgpop = display_popup(3, min(MAP_MAX_Y + 4, LINES - 4), 0, NULL, message, 0);
@@ -2485,7 +2486,7 @@ position display_get_new_position(player *p,
 
             /* jump to next visible monster */
         case KEY_SPC:
-            if ((mlist == NULL) && visible)
+            if ((mlist == NULL || mlist->len == 0) && visible)
             {
                 flash();
             }
@@ -2493,11 +2494,11 @@ position display_get_new_position(player *p,
             {
                 /* jump to the next list entry or to the start of
                    the list if the end has been reached */
-                if ((miter = miter->next) == NULL)
-                    miter = mlist;
+                if (++midx >= mlist->len)
+                    midx = 0;
 
                 /* get the currently selected monster */
-                m = (monster *)miter->data;
+                m = g_ptr_array_index(mlist, midx);
 
                 /* jump to the selected monster */
                 npos = monster_pos(m);
@@ -2660,10 +2661,6 @@ position display_get_new_position(player *p,
     }
     while (RUN);
 
-    /* destroy list of visible monsters */
-    if (mlist != NULL)
-        g_list_free(mlist);
-
     /* destroy the message pop-up */
     display_window_destroy(msgpop);
 
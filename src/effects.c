@@ -610,16 +610,14 @@ void effect_serialize(gpointer oid, effect *e, cJSON *root)
     }
 }
 
-effect *effect_deserialize(cJSON *eser, game *g)
+effect *effect_deserialize(cJSON *eser)
 {
     effect *e;
-    guint oid;
     cJSON *itm;
 
     e = g_malloc0(sizeof(effect));
 
-    oid = cJSON_GetObjectItem(eser, "oid")->valueint;
-    e->oid =  GUINT_TO_POINTER(oid);
+    e->oid = GUINT_TO_POINTER(cJSON_GetObjectItem(eser, "oid")->valueint);
 
     e->type = cJSON_GetObjectItem(eser, "type")->valueint;
     e->start = cJSON_GetObjectItem(eser, "start")->valueint;
@@ -631,15 +629,6 @@ effect *effect_deserialize(cJSON *eser, game *g)
         e->item = GUINT_TO_POINTER(itm->valueint);
     }
 
-    /* add effect to game */
-    g_hash_table_insert(g->effects, e->oid, e);
-
-    /* increase max_id to match used ids */
-    if (g->effect_max_id < oid)
-    {
-        g->effect_max_id = oid;
-    }
-
     return e;
 }
 
@@ -253,6 +253,7 @@ typedef struct
     size_t offset;
     size_t depth; /* How deeply nested (in arrays/objects) is the input at the current offset. */
     internal_hooks hooks;
+    cJSON_bool in_situ; /* strings are unescaped into the input buffer instead of being copied */
 } parse_buffer;
 
 /* check if the given size is left to read in a given parse buffer (starting with 1) */
@@ -735,7 +736,16 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
 
         /* This is at most how much we need for the output */
         allocation_length = (size_t) (input_end - buffer_at_offset(input_buffer)) - skipped_bytes;
-        output = (unsigned char*)input_buffer->hooks.allocate(allocation_length + sizeof(""));
+        if (input_buffer->in_situ)
+        {
+            /* unescaping never makes a string longer, the closing quote
+               leaves room for the terminating zero */
+            output = (unsigned char*)buffer_at_offset(input_buffer) + 1;
+        }
+        else
+        {
+            output = (unsigned char*)input_buffer->hooks.allocate(allocation_length + sizeof(""));
+        }
         if (output == NULL)
         {
             goto fail; /* allocation failure */
@@ -805,13 +815,19 @@ static cJSON_bool parse_string(cJSON * const item, parse_buffer * const input_bu
     item->type = cJSON_String;
     item->valuestring = (char*)output;
 
+    if (input_buffer->in_situ)
+    {
+        /* the string is owned by the input buffer */
+        item->type |= cJSON_IsReference;
+    }
+
     input_buffer->offset = (size_t) (input_end - input_buffer->content);
     input_buffer->offset++;
 
     return true;
 
 fail:
-    if (output != NULL)
+    if ((output != NULL) && !input_buffer->in_situ)
     {
         input_buffer->hooks.deallocate(output);
     }
@@ -998,9 +1014,9 @@ static parse_buffer *skip_utf8_bom(parse_buffer * const buffer)
 }
 
 /* Parse an object - create a new root, and populate. */
-CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated)
+static cJSON *parse_with_opts(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated, cJSON_bool in_situ)
 {
-    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0 } };
+    parse_buffer buffer = { 0, 0, 0, 0, { 0, 0, 0 }, 0 };
     cJSON *item = NULL;
 
     /* reset error position */
@@ -1016,6 +1032,7 @@ CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return
     buffer.length = strlen((const char*)value) + sizeof("");
     buffer.offset = 0;
     buffer.hooks = global_hooks;
+    buffer.in_situ = in_situ;
 
     item = cJSON_New_Item(&global_hooks);
     if (item == NULL) /* memory fail */
@@ -1077,12 +1094,22 @@ fail:
     return NULL;
 }
 
+CJSON_PUBLIC(cJSON *) cJSON_ParseWithOpts(const char *value, const char **return_parse_end, cJSON_bool require_null_terminated)
+{
+    return parse_with_opts(value, return_parse_end, require_null_terminated, false);
+}
+
 /* Default options for cJSON_Parse */
 CJSON_PUBLIC(cJSON *) cJSON_Parse(const char *value)
 {
     return cJSON_ParseWithOpts(value, 0, 0);
 }
 
+CJSON_PUBLIC(cJSON *) cJSON_ParseInSitu(char *value)
+{
+    return parse_with_opts(value, 0, 0, true);
+}
+
 #define cjson_min(a, b) ((a < b) ? a : b)
 
 static unsigned char *print(const cJSON * const item, cJSON_bool format, const internal_hooks * const hooks)
@@ -1563,6 +1590,10 @@ static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_bu
         /* swap valuestring and string, because we parsed the name */
         current_item->string = current_item->valuestring;
         current_item->valuestring = NULL;
+        if (input_buffer->in_situ)
+        {
+            current_item->type = cJSON_StringIsConst;
+        }
 
         if (cannot_access_at_index(input_buffer, 0) || (buffer_at_offset(input_buffer)[0] != ':'))
         {
@@ -1576,6 +1607,10 @@ static cJSON_bool parse_object(cJSON * const item, parse_buffer * const input_bu
         {
             goto fail; /* failed to parse value */
         }
+        if (input_buffer->in_situ)
+        {
+            current_item->type |= cJSON_StringIsConst;
+        }
         buffer_skip_whitespace(input_buffer);
     }
     while (can_access_at_index(input_buffer, 0) && (buffer_at_offset(input_buffer)[0] == ','));
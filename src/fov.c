@@ -25,12 +25,47 @@
 #include "position.h"
 
 static void fov_calculate_octant(fov *fv, map *m, position center,
-                                 gboolean infravision, int row,
-                                 float start, float end, int radius,
+                                 int radius, int xx, int xy, int yx, int yy);
+static void fov_reference_octant(fov *fv, map *m, position center,
+                                 int row, float start, float end, int radius,
                                  int xx, int xy, int yx, int yy);
 
+static void fov_reference_calculate(fov *fv, map *m, position pos, int radius,
+                                    gboolean infravision);
 static gint fov_visible_monster_sort(gconstpointer a, gconstpointer b, gpointer center);
 
+/* the values stored for every position of the fov */
+#define FOV_VISIBLE  1 /* the position can be seen */
+#define FOV_MONSTERS 2 /* monsters at the position can be seen */
+
+/*
+ * The slopes of the shadowcasting algorithm are fractions of small
+ * integers. Keeping them as such avoids rounding and float divisions.
+ */
+typedef struct _fov_slope
+{
+    int num;
+    int den; /* always positive */
+} fov_slope;
+
+/* a part of an octant that remains to be scanned, starting at a row */
+typedef struct _fov_scan
+{
+    int row;
+    fov_slope start;
+    fov_slope end;
+} fov_scan;
+
+/* scans started for the current octant, a hash set with open addressing */
+#define FOV_SEEN_BITS 10
+#define FOV_SEEN_SIZE (1 << FOV_SEEN_BITS)
+
+typedef struct _fov_seen
+{
+    guint64 key;
+    guint32 stamp; /* the octant the entry belongs to */
+} fov_seen;
+
 struct _fov
 {
     /* the actual field of vision */
@@ -39,33 +74,79 @@ struct _fov
     /* the center of the fov */
     position center;
 
-    /* The list of visible monsters - it's a hash as fields may get visited
-       twice, which means that monsters may get added to the list multiple
-       times. The hash overwrites duplicate values. */
-    GHashTable *mlist;
+    /* the radius and the map revision of the last calculated fov;
+       only valid if calculated is set */
+    int radius;
+    guint32 revision;
+    gboolean calculated;
+
+    /* the positions set visible */
+    GArray *visible;
+
+    /* the positions that were not visible in the previous fov and the
+       visibility of the previous fov to determine them */
+    GArray *gained;
+    gboolean gained_valid;
+    guchar prev[MAP_MAX_Y][MAP_MAX_X];
+
+    /* the rectangle containing all positions to check for monsters */
+    int mon_x1, mon_y1, mon_x2, mon_y2;
+
+    /* the visible monsters, sorted by their distance to the center */
+    GPtrArray *mlist;
+
+    /* the scans of an octant waiting to be done */
+    GArray *scans;
+
+    /* the scans of the current octant that have been started */
+    fov_seen *seen;
+    guint seen_len;
+    guint32 stamp;
+};
+
+/* the octants of the fov, given as multipliers to get the map coordinates */
+static const int fov_mult[4][8] =
+{
+    { 1,  0,  0, -1, -1,  0,  0,  1 },
+    { 0,  1, -1,  0,  0, -1,  1,  0 },
+    { 0,  1,  1,  0,  0, -1, -1,  0 },
+    { 1,  0,  0,  1, -1,  0,  0, -1 }
 };
 
 fov *fov_new()
 {
     fov *nfov = g_malloc0(sizeof(fov));
-    nfov->center = pos_invalid;
-    nfov->mlist = g_hash_table_new(g_direct_hash, g_direct_equal);
+    nfov->mlist = g_ptr_array_new();
+    nfov->visible = g_array_new(FALSE, FALSE, sizeof(position));
+    nfov->gained = g_array_new(FALSE, FALSE, sizeof(position));
+    nfov->scans = g_array_new(FALSE, FALSE, sizeof(fov_scan));
+    nfov->seen = g_new0(fov_seen, FOV_SEEN_SIZE);
+
+    fov_reset(nfov);
 
     return nfov;
 }
-/* this and the function fov_calculate_octant() have been
- * ported from python to c using the example at
- * http://roguebasin.roguelikedevelopment.org/index.php?title=Python_shadowcasting_implementation
- */
+
 void fov_calculate(fov *fv, map *m, position pos, int radius, gboolean infravision)
 {
-    const int mult[4][8] =
+    /* the previous fov is comparable if nothing on the map has changed
+       that could change the visibility of a position */
+    const gboolean comparable = fv->calculated
+                                && Z(fv->center) == m->nlevel
+                                && fv->revision == m->revision;
+
+    if (comparable && pos_identical(fv->center, pos) && fv->radius == radius)
     {
-        { 1,  0,  0, -1, -1,  0,  0,  1 },
-        { 0,  1, -1,  0,  0, -1,  1,  0 },
-        { 0,  1,  1,  0,  0, -1, -1,  0 },
-        { 1,  0,  0,  1, -1,  0,  0, -1 }
-    };
+        /* the fov has not changed, only the monsters may have */
+        g_array_set_size(fv->gained, 0);
+        fv->gained_valid = TRUE;
+        fov_find_monsters(fv, m, infravision);
+
+        return;
+    }
+
+    if (comparable)
+        memcpy(fv->prev, fv->data, sizeof(fv->data));
 
     /* reset the entire fov to unseen */
     fov_reset(fv);
@@ -76,13 +157,30 @@ void fov_calculate(fov *fv, map *m, position pos, int radius, gboolean infravisi
     /* determine which fields are visible */
     for (int octant = 0; octant < 8; octant++)
     {
-        fov_calculate_octant(fv, m, pos, infravision,
-                             1, 1.0, 0.0, radius,
-                             mult[0][octant], mult[1][octant],
-                             mult[2][octant], mult[3][octant]);
+        fov_calculate_octant(fv, m, pos, radius,
+                             fov_mult[0][octant], fov_mult[1][octant],
+                             fov_mult[2][octant], fov_mult[3][octant]);
     }
 
-    fov_set(fv, pos, TRUE, infravision, TRUE);
+    fov_set(fv, pos, TRUE, TRUE);
+    fov_find_monsters(fv, m, infravision);
+
+    if (comparable)
+    {
+        for (guint idx = 0; idx < fv->visible->len; idx++)
+        {
+            position vpos = g_array_index(fv->visible, position, idx);
+
+            if (!fv->prev[Y(vpos)][X(vpos)])
+                g_array_append_val(fv->gained, vpos);
+        }
+
+        fv->gained_valid = TRUE;
+    }
+
+    fv->radius = radius;
+    fv->revision = m->revision;
+    fv->calculated = TRUE;
 }
 
 gboolean fov_get(fov *fv, position pos)
@@ -90,27 +188,80 @@ gboolean fov_get(fov *fv, position pos)
     g_assert (fv != NULL);
     g_assert (pos_valid(pos));
 
-    return fv->data[Y(pos)][X(pos)];
+    return fv->data[Y(pos)][X(pos)] & FOV_VISIBLE;
 }
 
-void fov_set(fov *fv, position pos, guchar visible,
-             gboolean infravision, gboolean mchk)
+void fov_set(fov *fv, position pos, guchar visible, gboolean mchk)
 {
     g_assert (fv != NULL);
     g_assert (pos_valid(pos));
 
-    fv->data[Y(pos)][X(pos)] = visible;
-    monster *mon;
+    if (!visible)
+    {
+        if (fv->data[Y(pos)][X(pos)])
+        {
+            for (guint idx = 0; idx < fv->visible->len; idx++)
+            {
+                if (pos_identical(g_array_index(fv->visible, position, idx), pos))
+                {
+                    g_array_remove_index_fast(fv->visible, idx);
+                    break;
+                }
+            }
+        }
+
+        fv->data[Y(pos)][X(pos)] = 0;
+        fv->calculated = FALSE;
+        return;
+    }
+
+    /* positions may be set several times */
+    if (!fv->data[Y(pos)][X(pos)])
+        g_array_append_val(fv->visible, pos);
+
+    fv->data[Y(pos)][X(pos)] |= FOV_VISIBLE | (mchk ? FOV_MONSTERS : 0);
+
+    if (mchk)
+    {
+        /* extend the area searched by fov_find_monsters() */
+        fv->mon_x1 = min(fv->mon_x1, X(pos));
+        fv->mon_y1 = min(fv->mon_y1, Y(pos));
+        fv->mon_x2 = max(fv->mon_x2, X(pos));
+        fv->mon_y2 = max(fv->mon_y2, Y(pos));
+    }
+}
 
-    /* If advised to do so, check if there is a monster at that
-       position. Must not be an unknown mimic or invisible. */
-    if (mchk && (mon = map_get_monster_at(game_map(nlarn, Z(pos)), pos))
-        && !monster_unknown(mon)
-        && (!monster_flags(mon, INVISIBLE) || infravision))
+void fov_find_monsters(fov *fv, map *m, gboolean infravision)
+{
+    g_assert (fv != NULL && m != NULL);
+
+    g_ptr_array_set_size(fv->mlist, 0);
+
+    for (int y = fv->mon_y1; y <= fv->mon_y2; y++)
     {
-        /* found a visible monster -> add it to the list */
-        g_hash_table_insert(fv->mlist, mon, 0);
+        for (int x = fv->mon_x1; x <= fv->mon_x2; x++)
+        {
+            monster *mon;
+
+            /* the oid of the monster is enough to skip empty positions */
+            if (!(fv->data[y][x] & FOV_MONSTERS) || !m->grid[y][x].m_oid)
+                continue;
+
+            position pos = { { x, y, m->nlevel } };
+
+            /* Must not be an unknown mimic or invisible. */
+            if ((mon = map_get_monster_at(m, pos))
+                && !monster_unknown(mon)
+                && (!monster_flags(mon, INVISIBLE) || infravision))
+            {
+                g_ptr_array_add(fv->mlist, mon);
+            }
+        }
     }
+
+    /* sort the list of monsters by distance */
+    g_ptr_array_sort_with_data(fv->mlist, fov_visible_monster_sort,
+                               &fv->center);
 }
 
 void fov_reset(fov *fv)
@@ -123,63 +274,246 @@ void fov_reset(fov *fv)
     /* set the center to an invalid position */
     fv->center = pos_invalid;
 
+    /* the next fov cannot be compared to this one */
+    fv->calculated = FALSE;
+    fv->gained_valid = FALSE;
+    g_array_set_size(fv->visible, 0);
+    g_array_set_size(fv->gained, 0);
+
     /* clean list of visible monsters */
-    g_hash_table_remove_all(fv->mlist);
+    g_ptr_array_set_size(fv->mlist, 0);
+    fv->mon_x1 = MAP_MAX_X;
+    fv->mon_y1 = MAP_MAX_Y;
+    fv->mon_x2 = fv->mon_y2 = -1;
 }
 
 monster *fov_get_closest_monster(fov *fv)
 {
-    monster *closest_monster = NULL;
+    g_assert (fv != NULL);
 
-    if (g_hash_table_size(fv->mlist) > 0)
-    {
-        GList *mlist;
+    return (fv->mlist->len > 0) ? g_ptr_array_index(fv->mlist, 0) : NULL;
+}
 
-        /* get the list of all visible monsters */
-        mlist = g_hash_table_get_keys(fv->mlist);
+GPtrArray *fov_get_visible_monsters(fov *fv)
+{
+    g_assert (fv != NULL);
 
-        /* sort the monsters list by distance */
-        mlist = g_list_sort_with_data(mlist, fov_visible_monster_sort,
-                                      &fv->center);
+    return fv->mlist;
+}
 
-        /* get the first element in the list */
-        closest_monster = mlist->data;
+GArray *fov_get_visible(fov *fv)
+{
+    g_assert (fv != NULL);
+
+    return fv->visible;
+}
+
+GArray *fov_get_gained(fov *fv)
+{
+    g_assert (fv != NULL);
 
-        g_list_free(mlist);
+    return fv->gained_valid ? fv->gained : NULL;
+}
+
+void fov_free(fov *fv)
+{
+    g_assert (fv != NULL);
+
+    /* free the allocated memory */
+    g_ptr_array_free(fv->mlist, TRUE);
+    g_array_free(fv->visible, TRUE);
+    g_array_free(fv->gained, TRUE);
+    g_array_free(fv->scans, TRUE);
+    g_free(fv->seen);
+    g_free(fv);
+}
+
+/* TRUE if slope a is smaller than slope b */
+static inline gboolean fov_slope_less(fov_slope a, fov_slope b)
+{
+    return a.num * b.den < b.num * a.den;
+}
+
+/* forget the scans started for the previous octant */
+static void fov_seen_clear(fov *fv)
+{
+    if (++fv->stamp == 0)
+    {
+        /* the stamps have wrapped around */
+        memset(fv->seen, 0, FOV_SEEN_SIZE * sizeof(fov_seen));
+        fv->stamp = 1;
     }
 
-    return closest_monster;
+    fv->seen_len = 0;
 }
 
-GList *fov_get_visible_monsters(fov *fv)
+/* add a scan to the set of started scans; returns TRUE if it was there */
+static gboolean fov_seen_add(fov *fv, guint64 key)
 {
-    GList *mlist = NULL;
+    guint idx = (key * G_GUINT64_CONSTANT(0x9E3779B97F4A7C15))
+                >> (64 - FOV_SEEN_BITS);
 
-    if (g_hash_table_size(fv->mlist) != 0)
+    while (fv->seen[idx].stamp == fv->stamp)
     {
-        /* get a GList of all visible monster all */
-        mlist = g_hash_table_get_keys(fv->mlist);
+        if (fv->seen[idx].key == key)
+            return TRUE;
+
+        idx = (idx + 1) & (FOV_SEEN_SIZE - 1);
+    }
 
-        /* sort the list of monster by distance */
-        mlist = g_list_sort_with_data(mlist, fov_visible_monster_sort,
-                                      &fv->center);
+    /* when the set is full, scans may be repeated */
+    if (fv->seen_len < FOV_SEEN_SIZE / 2)
+    {
+        fv->seen[idx].key = key;
+        fv->seen[idx].stamp = fv->stamp;
+        fv->seen_len++;
     }
 
-    return mlist;
+    return FALSE;
 }
 
-void fov_free(fov *fv)
+static inline void fov_scan_push(fov *fv, int row, fov_slope start,
+                                 fov_slope end)
 {
-    g_assert (fv != NULL);
+    /* the numerators and denominators of the slopes range from -1 to
+       2 * row + 1 and rows end at the map border, thus each of the
+       values fits into twelve bits */
+    const guint64 key = (guint64)row
+                        | (guint64)(start.num + 1) << 12
+                        | (guint64)start.den << 24
+                        | (guint64)(end.num + 1) << 36
+                        | (guint64)end.den << 48;
+
+    /* the result of a scan only depends on its row and slopes */
+    if (fov_seen_add(fv, key))
+        return;
 
-    /* free the allocated memory */
-    g_hash_table_destroy(fv->mlist);
-    g_free(fv);
+    fov_scan scan = { row, start, end };
+    g_array_append_val(fv->scans, scan);
 }
 
+/*
+ * Recursive shadowcasting of an octant, with the recursion replaced by
+ * a stack of scans and the slopes kept as fractions. Rows are scanned
+ * from the center outwards. A scan covers the part of the following rows
+ * between its start and end slopes; it continues with the next row until
+ * the last cell of the row blocks the view.
+ *
+ * Like the original implementation, a new scan is started for the part
+ * to the left of every cell that is not preceded by a blocking one. This
+ * finds a few more visible cells than starting scans only at blocking
+ * cells. Identical scans are done once, which keeps this from getting
+ * expensive in open areas.
+ */
 static void fov_calculate_octant(fov *fv, map *m, position center,
-                                 gboolean infravision, int row,
-                                 float start, float end, int radius,
+                                 int radius, int xx, int xy, int yx, int yy)
+{
+    const int radius_squared = radius * radius;
+
+    /* cells beyond the radius cannot be seen, rows beyond the map
+       width do not contain any cell of the map */
+    const int rows = min(radius, MAP_MAX_X);
+
+    fov_seen_clear(fv);
+    fov_scan_push(fv, 1, (fov_slope){ 1, 1 }, (fov_slope){ 0, 1 });
+
+    while (fv->scans->len > 0)
+    {
+        fov_scan scan = g_array_index(fv->scans, fov_scan, fv->scans->len - 1);
+        g_array_set_size(fv->scans, fv->scans->len - 1);
+
+        if (fov_slope_less(scan.start, scan.end))
+            continue;
+
+        for (int j = scan.row; j < rows; j++)
+        {
+            fov_slope new_start = { 0, 1 };
+            gboolean blocked = FALSE;
+
+            /* the cells of the row from left to right */
+            for (int dx = -j; dx <= 0; dx++)
+            {
+                const int dy = -j;
+
+                /* translate the dx, dy coordinates into map coordinates */
+                const int x = X(center) + dx * xx + dy * xy;
+                const int y = Y(center) + dx * yx + dy * yy;
+
+                if ((x < 0) || (x >= MAP_MAX_X) || (y < 0) || (y >= MAP_MAX_Y))
+                    continue;
+
+                /* the slopes of the left and right extremities of the cell */
+                const fov_slope l_slope = { 1 - 2 * dx, 2 * j - 1 };
+                const fov_slope r_slope = { -1 - 2 * dx, 2 * j + 1 };
+
+                if (fov_slope_less(scan.start, r_slope))
+                    continue;
+
+                if (fov_slope_less(l_slope, scan.end))
+                    break;
+
+                position pos = { { x, y, m->nlevel } };
+
+                /* the light beam is touching this cell */
+                if ((dx * dx + dy * dy) < radius_squared)
+                    fov_set(fv, pos, TRUE, TRUE);
+
+                if (blocked)
+                {
+                    /* scanning a run of blocking cells */
+                    if (!map_pos_transparent(m, pos))
+                    {
+                        new_start = r_slope;
+                        continue;
+                    }
+
+                    blocked = FALSE;
+                    scan.start = new_start;
+                }
+                else
+                {
+                    /* a blocking cell starts a run of blocking cells */
+                    if (!map_pos_transparent(m, pos))
+                        blocked = TRUE;
+
+                    if (j + 1 < rows)
+                        fov_scan_push(fv, j + 1, scan.start, l_slope);
+
+                    new_start = r_slope;
+                }
+            }
+
+            /* the row ends with a blocking cell */
+            if (blocked)
+                break;
+        }
+    }
+}
+
+static void fov_reference_calculate(fov *fv, map *m, position pos, int radius,
+                                    gboolean infravision)
+{
+    fov_reset(fv);
+    fv->center = pos;
+
+    for (int octant = 0; octant < 8; octant++)
+    {
+        fov_reference_octant(fv, m, pos, 1, 1.0, 0.0, radius,
+                             fov_mult[0][octant], fov_mult[1][octant],
+                             fov_mult[2][octant], fov_mult[3][octant]);
+    }
+
+    fov_set(fv, pos, TRUE, TRUE);
+    fov_find_monsters(fv, m, infravision);
+}
+
+/* The original shadowcasting algorithm ported from python to c using the
+ * example at
+ * http://roguebasin.roguelikedevelopment.org/index.php?title=Python_shadowcasting_implementation
+ * It is kept to check fov_calculate_octant() against.
+ */
+static void fov_reference_octant(fov *fv, map *m, position center,
+                                 int row, float start, float end, int radius,
                                  int xx, int xy, int yx, int yy)
 {
     int radius_squared;
@@ -234,7 +568,7 @@ static void fov_calculate_octant(fov *fv, map *m, position center,
                 /* Our light beam is touching this square; light it */
                 if ((dx * dx + dy * dy) < radius_squared)
                 {
-                    fov_set(fv, pos, TRUE, infravision, TRUE);
+                    fov_set(fv, pos, TRUE, TRUE);
                 }
 
                 if (blocked)
@@ -259,8 +593,7 @@ static void fov_calculate_octant(fov *fv, map *m, position center,
                         blocked = TRUE;
                     }
 
-                    fov_calculate_octant(fv, m, center, infravision,
-                                         j + 1, start, l_slope,
+                    fov_reference_octant(fv, m, center, j + 1, start, l_slope,
                                          radius, xx, xy, yx, yy);
 
                     new_start = r_slope;
@@ -280,8 +613,8 @@ static gint fov_visible_monster_sort(gconstpointer a, gconstpointer b, gpointer
 {
     monster *ma, *mb;
 
-    ma = (monster*)a;
-    mb = (monster*)b;
+    ma = *(monster **)a;
+    mb = *(monster **)b;
 
     int da = pos_distance(*(position *)center, monster_pos(ma));
     int db = pos_distance(*(position *)center, monster_pos(mb));
@@ -292,5 +625,181 @@ static gint fov_visible_monster_sort(gconstpointer a, gconstpointer b, gpointer
     if (da > db)
         return 1;
 
-    return 0;
+    /* keep the order of the map for monsters at the same distance */
+    if (Y(monster_pos(ma)) != Y(monster_pos(mb)))
+        return Y(monster_pos(ma)) - Y(monster_pos(mb));
+
+    return X(monster_pos(ma)) - X(monster_pos(mb));
+}
+
+/* the number of visible positions */
+static guint fov_count(fov *fv)
+{
+    guint count = 0;
+
+    for (int y = 0; y < MAP_MAX_Y; y++)
+        for (int x = 0; x < MAP_MAX_X; x++)
+            count += (fv->data[y][x] != 0);
+
+    return count;
+}
+
+/* check the positions that have become visible against the previous fov */
+static gboolean fov_gained_valid(fov *fv, fov *prev)
+{
+    GArray *gained = fov_get_gained(fv);
+    guint count = 0;
+
+    /* the previous fov was of another map */
+    if (gained == NULL)
+        return TRUE;
+
+    for (int y = 0; y < MAP_MAX_Y; y++)
+        for (int x = 0; x < MAP_MAX_X; x++)
+            count += (fv->data[y][x] && !prev->data[y][x]);
+
+    if (count != gained->len)
+        return FALSE;
+
+    for (guint idx = 0; idx < gained->len; idx++)
+    {
+        position pos = g_array_index(gained, position, idx);
+
+        if (!fov_get(fv, pos) || fov_get(prev, pos))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* the fovs timed by the benchmark */
+typedef struct _fov_bench
+{
+    const char *name;
+    int radius;
+    guint fovs;          /* fovs calculated per algorithm */
+    guint64 cells;       /* visible positions of these fovs */
+    gint64 time[2];      /* microseconds of the algorithm and the reference */
+} fov_bench;
+
+gboolean fov_benchmark(int runs)
+{
+    /* the player in the town and monsters in the dungeon */
+    fov_bench benches[] =
+    {
+        { "town",    15, 0, 0, { 0, 0 } },
+        { "dungeon", 6,  0, 0, { 0, 0 } },
+    };
+
+    fov *fv = fov_new(), *ref = fov_new();
+    guint checked = 0, mismatches = 0;
+
+    for (guint maze = 0; maze < MAP_MAZE_NUM; maze++)
+    {
+        /* keep the town the player is on */
+        const int num = 1 + maze % (MAP_MAX - 1);
+        fov_bench *bench = &benches[(maze == 0) ? 0 : 1];
+        GArray *positions = g_array_new(FALSE, FALSE, sizeof(position));
+        position pos = pos_invalid;
+
+        map_destroy(nlarn->maps[num]);
+        map *m = map_new_maze(num, nlarn->mazefile, maze);
+
+        if (m == NULL)
+        {
+            g_printerr("Failed to load maze %u.\n", maze);
+            fov_free(fv);
+            fov_free(ref);
+
+            return FALSE;
+        }
+
+        /* compare the results for every position of the maze */
+        Z(pos) = num;
+        for (Y(pos) = 0; Y(pos) < MAP_MAX_Y; Y(pos)++)
+        {
+            for (X(pos) = 0; X(pos) < MAP_MAX_X; X(pos)++)
+            {
+                for (int radius = 6; radius <= 15; radius += 9)
+                {
+                    fov_calculate(fv, m, pos, radius, FALSE);
+
+                    /* the reference still holds the previous fov */
+                    gboolean gained_ok = fov_gained_valid(fv, ref);
+
+                    fov_reference_calculate(ref, m, pos, radius, FALSE);
+
+                    checked++;
+
+                    if (memcmp(fv->data, ref->data, sizeof(fv->data)) != 0
+                            || fv->mlist->len != ref->mlist->len
+                            || !gained_ok)
+                        mismatches++;
+
+                    /* calculating the same fov again has to keep it */
+                    fov_calculate(fv, m, pos, radius, FALSE);
+
+                    if (memcmp(fv->data, ref->data, sizeof(fv->data)) != 0
+                            || fov_get_gained(fv)->len > 0)
+                        mismatches++;
+
+                    if (radius == bench->radius && map_pos_passable(m, pos))
+                        bench->cells += (guint64)fov_count(fv) * runs;
+                }
+
+                if (map_pos_passable(m, pos))
+                    g_array_append_val(positions, pos);
+            }
+        }
+
+        /* time the fovs of all positions that can be entered */
+        for (int algorithm = 0; algorithm < 2; algorithm++)
+        {
+            gint64 start = g_get_monotonic_time();
+
+            for (int run = 0; run < runs; run++)
+            {
+                for (guint idx = 0; idx < positions->len; idx++)
+                {
+                    if (algorithm == 0)
+                        fov_calculate(fv, m, g_array_index(positions, position, idx),
+                                      bench->radius, FALSE);
+                    else
+                        fov_reference_calculate(ref, m, g_array_index(positions, position, idx),
+                                                bench->radius, FALSE);
+                }
+            }
+
+            bench->time[algorithm] += g_get_monotonic_time() - start;
+        }
+
+        bench->fovs += positions->len * runs;
+        g_array_free(positions, TRUE);
+    }
+
+    fov_free(fv);
+    fov_free(ref);
+
+    g_print("Calculating fovs on %d mazes, %d runs\n\n", MAP_MAZE_NUM, runs);
+    g_print("%-8s %6s %-14s %9s %9s %12s\n", "maps", "radius", "algorithm",
+            "fovs", "us/fov", "cells/s");
+
+    for (guint idx = 0; idx < G_N_ELEMENTS(benches); idx++)
+    {
+        for (int algorithm = 0; algorithm < 2; algorithm++)
+        {
+            const double time = max(benches[idx].time[algorithm], 1);
+
+            g_print("%-8s %6d %-14s %9u %9.2f %12.0f\n", benches[idx].name,
+                    benches[idx].radius,
+                    (algorithm == 0) ? "shadowcasting" : "reference",
+                    benches[idx].fovs, time / max(benches[idx].fovs, 1),
+                    benches[idx].cells * (double)G_USEC_PER_SEC / time);
+        }
+    }
+
+    g_print("\n%u fovs compared to the reference, %u differ\n",
+            checked, mismatches);
+
+    return (mismatches == 0);
 }
@@ -34,14 +34,18 @@
 #include <sys/param.h>
 
 #if (defined __unix) || (defined __unix__) || (defined __APPLE__)
+# include <fcntl.h>
 # include <unistd.h>
 # include <sys/file.h>
+# include <sys/resource.h>
 # include <sys/stat.h>
 #endif
 
 #ifdef WIN32
 # include <io.h>
 # include <sys/locking.h>
+# define ftruncate _chsize
+# define fsync _commit
 #endif
 
 #include "cJSON.h"
@@ -55,7 +59,12 @@
 #include "random.h"
 
 static void game_new();
-static gboolean game_load();
+static gboolean game_load(const char *filename, gboolean lock);
+static cJSON *game_serialize(game *g, gboolean full);
+static void game_save_finish(game *g);
+static void game_save_chunks_free();
+static void game_clear(game *g);
+static gboolean game_benchmark_save(int runs);
 static void game_items_shuffle(game *g);
 
 static const char *default_lib_dir = "/usr/share/nlarn";
@@ -109,6 +118,51 @@ static int try_locking_savegame_file(FILE *sg)
     return fd;
 }
 
+static gboolean game_convert_savefile(struct game_config *conf)
+{
+    if (conf->export_save)
+    {
+        /* write the user's saved game as plain JSON */
+        if (!game_load(nlarn->savefile, FALSE))
+        {
+            g_printerr("Could not open save file \"%s\".\n", nlarn->savefile);
+            return FALSE;
+        }
+
+        cJSON *save = game_serialize(nlarn, TRUE);
+        char *sg = cJSON_Print(save);
+        cJSON_Delete(save);
+
+        GError *error = NULL;
+        gboolean success = g_file_set_contents(conf->export_save, sg, -1, &error);
+        free(sg);
+
+        if (!success)
+        {
+            g_printerr("Failed to write \"%s\": %s\n", conf->export_save,
+                       error->message);
+            g_error_free(error);
+        }
+
+        return success;
+    }
+
+    /* convert a saved game in any supported format to the current format */
+    if (!game_load(conf->import_save, FALSE))
+    {
+        g_printerr("Could not open save file \"%s\".\n", conf->import_save);
+        return FALSE;
+    }
+
+    if (!game_save(nlarn))
+    {
+        g_printerr("Failed to write save file \"%s\".\n", nlarn->savefile);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
 /* the game settings */
 static struct game_config config = {};
 
@@ -270,6 +324,39 @@ void game_init(int argc, char *argv[])
     /* try to load settings from the configuration file */
     parse_ini_file(nlarn->inifile, &config);
 
+    /* determine how to compress saved games and the scoreboard */
+    nlarn->compression = parse_compression(&config);
+
+    /* assemble the save file name */
+    nlarn->savefile = g_build_path(G_DIR_SEPARATOR_S, game_userdir(),
+            save_file, NULL);
+
+    /* convert saved games between the binary and the JSON format */
+    if (config.export_save || config.import_save)
+    {
+        exit(game_convert_savefile(&config) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    /* time saving and loading */
+    if (config.bench_save > 0)
+    {
+        exit(game_benchmark_save(config.bench_save) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    /* time and verify path finding */
+    if (config.bench_paths > 0)
+    {
+        game_new();
+        exit(map_benchmark_paths(config.bench_paths) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    /* time and verify the fov calculation */
+    if (config.bench_fov > 0)
+    {
+        game_new();
+        exit(fov_benchmark(config.bench_fov) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
 #ifdef SDLPDCURSES
     /* If a font size was defined, export it to the environment
      * before initialising PDCurses. */
@@ -290,11 +377,7 @@ void game_init(int argc, char *argv[])
     /* set autosave setting (default: TRUE) */
     game_autosave(nlarn) = !config.no_autosave;
 
-    /* assemble the save file name */
-    nlarn->savefile = g_build_path(G_DIR_SEPARATOR_S, game_userdir(),
-            save_file, NULL);
-
-    if (!game_load())
+    if (!game_load(nlarn->savefile, TRUE))
     {
         /* set game parameters */
         game_difficulty(nlarn) = config.difficulty;
@@ -333,6 +416,14 @@ void game_init(int argc, char *argv[])
         }
 
     } /* end new game only settings */
+    else
+    {
+        /* welcome message */
+        print_welcome_message(FALSE);
+
+        /* refresh FOV */
+        player_update_fov(nlarn->p);
+    }
 
     /* parse auto pick-up settings */
     if (config.auto_pickup && (nlarn->p != NULL))
@@ -344,35 +435,24 @@ void game_init(int argc, char *argv[])
     }
 }
 
-game *game_destroy(game *g)
+/* free the game data, keeping the settings and file names */
+static void game_clear(game *g)
 {
-    g_assert(g != NULL);
-
-    /* everything must go */
-    g_free(g->basedir);
-    g_free(g->libdir);
-
-    g_free(g->mesgfile);
-    g_free(g->helpfile);
-    g_free(g->mazefile);
-    g_free(g->fortunes);
-    g_free(g->highscores);
-    g_free(g->inifile);
-    g_free(g->savefile);
-
     for (int i = 0; i < MAP_MAX; i++)
     {
         if (g->maps[i] == NULL)
         {
             /* killed early during game initialisation */
-            g_free(g);
-            return NULL;
+            return;
         }
         map_destroy(g->maps[i]);
+        g->maps[i] = NULL;
     }
 
     player_destroy(g->p);
     log_destroy(g->log);
+    g->p = NULL;
+    g->log = NULL;
 
     if (g->store_stock)
         inv_destroy(g->store_stock, FALSE);
@@ -380,6 +460,11 @@ game *game_destroy(game *g)
     if (g->monastery_stock)
         inv_destroy(g->monastery_stock, FALSE);
 
+    if (g->player_home)
+        inv_destroy(g->player_home, FALSE);
+
+    g->store_stock = g->monastery_stock = g->player_home = NULL;
+
     g_hash_table_destroy(g->items);
     g_hash_table_destroy(g->effects);
     g_hash_table_destroy(g->monsters);
@@ -387,6 +472,33 @@ game *game_destroy(game *g)
 
     g_ptr_array_foreach(g->spheres, (GFunc)sphere_destroy, g);
     g_ptr_array_free(g->spheres, TRUE);
+
+    g->items = g->effects = g->monsters = NULL;
+    g->dead_monsters = g->spheres = NULL;
+    g->item_max_id = g->effect_max_id = g->monster_max_id = 0;
+}
+
+game *game_destroy(game *g)
+{
+    g_assert(g != NULL);
+
+    /* do not leave a saved game half-written */
+    game_save_finish(g);
+    game_save_chunks_free();
+
+    /* everything must go */
+    g_free(g->basedir);
+    g_free(g->libdir);
+
+    g_free(g->mesgfile);
+    g_free(g->helpfile);
+    g_free(g->mazefile);
+    g_free(g->fortunes);
+    g_free(g->highscores);
+    g_free(g->inifile);
+    g_free(g->savefile);
+
+    game_clear(g);
     g_free(g);
 
     return NULL;
@@ -428,17 +540,9 @@ const gchar *game_userdir()
     return userdir;
 }
 
-int game_save(game *g)
+static cJSON *game_serialize(game *g, gboolean full)
 {
-    int err;
-    struct cJSON *save, *obj;
-    display_window *win = NULL;
-
-    g_assert(g != NULL);
-
-    /* if the display has been initialised, show a pop-up message */
-    if (display_available())
-        win = display_popup(2, 2, 0, NULL, "Saving....", 0);
+    cJSON *save, *obj;
 
     save = cJSON_CreateObject();
 
@@ -449,10 +553,13 @@ int game_save(game *g)
     cJSON_AddItemToObject(save, "rng_state", rand_serialize());
 
     /* maps */
-    cJSON_AddItemToObject(save, "maps", obj = cJSON_CreateArray());
-    for (int idx = 0; idx < MAP_MAX; idx++)
+    if (full)
     {
-        cJSON_AddItemToArray(obj, map_serialize(g->maps[idx]));
+        cJSON_AddItemToObject(save, "maps", obj = cJSON_CreateArray());
+        for (int idx = 0; idx < MAP_MAX; idx++)
+        {
+            cJSON_AddItemToArray(obj, map_serialize(g->maps[idx]));
+        }
     }
 
     cJSON_AddItemToObject(save, "amulet_created",
@@ -509,7 +616,7 @@ int game_save(game *g)
     cJSON_AddItemToObject(save, "log", log_serialize(g->log));
 
     /* add player */
-    cJSON_AddItemToObject(save, "player",  player_serialize(g->p));
+    cJSON_AddItemToObject(save, "player",  player_serialize(g->p, full));
 
     /* add items */
     cJSON_AddItemToObject(save, "items", obj = cJSON_CreateArray());
@@ -530,177 +637,640 @@ int game_save(game *g)
         g_ptr_array_foreach(g->spheres, (GFunc)sphere_serialize, obj);
     }
 
-    /* print save game into a string */
-    char *sg = cJSON_Print(save);
+    return save;
+}
 
-    /* free memory claimed by JSON structures */
-    cJSON_Delete(save);
+/*
+ * A saved game is assembled from chunks which are compressed separately:
+ * the file header with the game section, one chunk for every map, one
+ * for the player's memory of every map and the end marker. The chunks
+ * of the last save are kept; chunks that did not change since are not
+ * compressed again.
+ */
+#define SAVE_CHUNK_GAME   0
+#define SAVE_CHUNK_MAP    1
+#define SAVE_CHUNK_MEMORY (SAVE_CHUNK_MAP + MAP_MAX)
+#define SAVE_CHUNK_END    (SAVE_CHUNK_MEMORY + MAP_MAX)
+#define SAVE_CHUNK_MAX    (SAVE_CHUNK_END + 1)
+
+typedef struct _save_chunk
+{
+    GByteArray *raw; /* the sections as written last time */
+    GByteArray *gz;  /* the compressed sections, NULL if outdated */
+} save_chunk;
+
+static save_chunk save_chunks[SAVE_CHUNK_MAX];
 
-    /* open save file for writing */
-    FILE* fhandle;
-    if (sgfd)
+static void game_save_chunk_update(int idx, GByteArray *raw)
+{
+    save_chunk *chunk = &save_chunks[idx];
+
+    if (chunk->raw != NULL && chunk->raw->len == raw->len
+            && memcmp(chunk->raw->data, raw->data, raw->len) == 0)
     {
-        /*
-         * File is already opened.
-         * We need to open a duplicate of the file descriptor as gzclose
-         * would close the file descriptor we keep to ensure the lock
-         * on the file is kept.
-         */
-        fhandle = fdopen(dup(sgfd), "w");
-        /* Position at beginning of file, otherwise zlib would append */
-        rewind(fhandle);
+        /* unchanged since the last save */
+        g_byte_array_free(raw, TRUE);
+        return;
     }
-    else
+
+    if (chunk->raw != NULL)
+        g_byte_array_free(chunk->raw, TRUE);
+
+    if (chunk->gz != NULL)
+        g_byte_array_free(chunk->gz, TRUE);
+
+    chunk->raw = raw;
+    chunk->gz = NULL;
+}
+
+static void game_save_chunks_free()
+{
+    for (int idx = 0; idx < SAVE_CHUNK_MAX; idx++)
     {
-        /* File need to be opened for the first time */
-        fhandle = fopen(g->savefile, "wb");
+        if (save_chunks[idx].raw != NULL)
+            g_byte_array_free(save_chunks[idx].raw, TRUE);
+
+        if (save_chunks[idx].gz != NULL)
+            g_byte_array_free(save_chunks[idx].gz, TRUE);
+
+        save_chunks[idx].raw = save_chunks[idx].gz = NULL;
     }
+}
+
+static void game_serialize_binary(game *g)
+{
+    GByteArray *buf = g_byte_array_new();
+    guint section;
+
+    sf_put_header(buf);
+
+    /* the bulk of the game data is kept as compact JSON */
+    cJSON *save = game_serialize(g, FALSE);
+    char *sg = cJSON_PrintUnformatted(save);
+    cJSON_Delete(save);
+
+    /* include the terminating NUL to be able to parse the section in place */
+    section = sf_section_begin(buf, SFS_GAME);
+    sf_put_data(buf, sg, strlen(sg) + 1);
+    sf_section_end(buf, section);
+    free(sg);
+
+    game_save_chunk_update(SAVE_CHUNK_GAME, buf);
 
-    if (fhandle == NULL)
+    /* maps and the player's memory of them are stored as binary records */
+    for (int idx = 0; idx < MAP_MAX; idx++)
     {
-        log_add_entry(g->log, "Error opening save file \"%s\".", g->savefile);
-        free(sg);
-        return FALSE;
+        buf = g_byte_array_new();
+        section = sf_section_begin(buf, SFS_MAP);
+        map_serialize_binary(g->maps[idx], buf);
+        sf_section_end(buf, section);
+
+        game_save_chunk_update(SAVE_CHUNK_MAP + idx, buf);
     }
 
-    if (!sgfd)
+    for (int idx = 0; idx < MAP_MAX; idx++)
     {
-        /* first time save, try locking the file */
-        sgfd = try_locking_savegame_file(fhandle);
+        buf = g_byte_array_new();
+        section = sf_section_begin(buf, SFS_MEMORY);
+        player_memory_serialize_binary(g->p, idx, buf);
+        sf_section_end(buf, section);
+
+        game_save_chunk_update(SAVE_CHUNK_MEMORY + idx, buf);
     }
 
-    gzFile file = gzdopen(fileno(fhandle), "wb");
-    if (gzputs(file, sg) != (int)strlen(sg))
+    buf = g_byte_array_new();
+    sf_section_end(buf, sf_section_begin(buf, SFS_END));
+    game_save_chunk_update(SAVE_CHUNK_END, buf);
+}
+
+/* a saved game being written */
+typedef struct _save_job
+{
+    int fd;           /* the file written to */
+    int compression;  /* zlib compression level */
+    gchar *filename;  /* the saved game */
+    gchar *tmpname;   /* the temporary file, NULL when writing in place */
+    gchar *error;     /* error message if writing failed */
+} save_job;
+
+/* the thread writing a saved game in the background */
+static GThread *save_thread = NULL;
+
+static save_job *game_save_job_new(game *g)
+{
+    save_job *job = g_malloc0(sizeof(save_job));
+
+    job->compression = g->compression;
+    job->filename = g_strdup(g->savefile);
+
+#ifndef WIN32
+    /*
+     * Write to a new file which replaces the saved game once it is
+     * complete. The new file is locked before it becomes visible under
+     * the name of the saved game.
+     */
+    job->tmpname = g_strconcat(g->savefile, ".tmp", NULL);
+
+    /* another instance may be writing the file, thus it must not be
+       truncated before it has been locked; game_save_job_run() removes
+       the remains of a longer file after writing */
+    job->fd = open(job->tmpname, O_WRONLY | O_CREAT, 0644);
+
+    if (job->fd != -1 && flock(job->fd, LOCK_EX | LOCK_NB) == -1)
+    {
+        close(job->fd);
+        job->fd = -1;
+    }
+#else
+    /* Windows does not allow replacing a file that is open;
+       overwrite the locked file in place. */
+    if (!sgfd)
     {
-        log_add_entry(g->log, "Error writing save file \"%s\": %s",
-                g->savefile, gzerror(file, &err));
+        /* File need to be opened for the first time */
+        FILE *fhandle = fopen(g->savefile, "wb");
 
-        free(sg);
-        return FALSE;
+        /* first time save, try locking the file */
+        if (fhandle != NULL)
+            sgfd = try_locking_savegame_file(fhandle);
     }
 
-    free(sg);
-    gzclose(file);
+    /* Use a duplicate of the file descriptor as it is closed after
+       writing; the descriptor we keep ensures the lock is kept. */
+    job->fd = sgfd ? dup(sgfd) : -1;
+#endif
 
-    /* if a pop-up message has been opened, destroy it here */
-    if (win != NULL)
-        display_window_destroy(win);
+    if (job->fd == -1)
+        job->error = g_strdup_printf("Error opening save file \"%s\": %s",
+                                     job->filename, g_strerror(errno));
 
-    return TRUE;
+    return job;
 }
 
-map *game_map(game *g, guint nmap)
+#ifndef WIN32
+/* make sure the directory entries of a renamed file have reached the disk */
+static void game_sync_dir(const char *filename)
 {
-    g_assert (g != NULL && nmap < MAP_MAX);
+    gchar *dirname = g_path_get_dirname(filename);
+    int fd = open(dirname, O_RDONLY);
 
-    return g->maps[nmap];
+    if (fd != -1)
+    {
+        fsync(fd);
+        close(fd);
+    }
+
+    g_free(dirname);
 }
+#endif
 
-void game_spin_the_wheel(game *g)
+/* compress outdated chunks and write the saved game. Does not touch any
+   game data and may thus be called from any thread. */
+static save_job *game_save_job_run(save_job *job)
 {
-    map *amap;
+    gchar *error = NULL;
 
-    g_assert(g != NULL);
+    if (job->fd == -1)
+        return job;
 
-    /* add the player's speed to the player's movement points */
-    nlarn->p->movement += player_get_speed(nlarn->p);
+    /* Position at beginning of file, otherwise we would append */
+    lseek(job->fd, 0, SEEK_SET);
 
-    /* per-map actions */
-    for (int nmap = 0; nmap < MAP_MAX; nmap++)
+    for (int idx = 0; idx < SAVE_CHUNK_MAX && error == NULL; idx++)
     {
-        amap = game_map(g, nmap);
-
-        /* call map timers */
-        map_timer(amap);
+        save_chunk *chunk = &save_chunks[idx];
 
-        /* spawn some monsters every now and then */
-        if (g->gtime % (100 + nmap) == 0)
+        if (chunk->gz == NULL
+                && !(chunk->gz = sf_compress(chunk->raw->data, chunk->raw->len,
+                                             job->compression)))
         {
-            map_fill_with_life(amap);
+            error = g_strdup("compression failed");
+            break;
         }
-    }
 
-    amap = game_map(nlarn, Z(g->p->pos));
+        for (guint pos = 0; pos < chunk->gz->len; )
+        {
+            ssize_t written = write(job->fd, chunk->gz->data + pos,
+                                    chunk->gz->len - pos);
 
-    /* check if player is stuck inside a wall without walk through wall */
-    if ((map_tiletype_at(amap, g->p->pos) == LT_WALL)
-            && !player_effect(g->p, ET_WALL_WALK))
-    {
-        player_die(g->p, PD_STUCK, 0);
+            if (written <= 0)
+            {
+                error = g_strdup(g_strerror(errno));
+                break;
+            }
+
+            pos += written;
+        }
     }
 
-    /* check if the player is on a deep water tile without levitation */
-    if ((map_tiletype_at(amap, g->p->pos) == LT_DEEPWATER)
-            && !player_effect(g->p, ET_LEVITATION))
+    /* remove the remains of a longer previous save and make sure
+       the data has reached the disk */
+    if (error == NULL && (ftruncate(job->fd, lseek(job->fd, 0, SEEK_CUR)) != 0
+                          || fsync(job->fd) != 0))
     {
-        player_die(g->p, PD_DROWNED, 0);
+        error = g_strdup(g_strerror(errno));
     }
 
-    /* check if the player is on a lava tile without levitation */
-    if ((map_tiletype_at(amap, g->p->pos) == LT_LAVA)
-            && !player_effect(g->p, ET_LEVITATION))
+    /* replace the previous saved game */
+    if (error == NULL && job->tmpname != NULL)
     {
-        player_die(g->p, PD_MELTED, 0);
+        if (g_rename(job->tmpname, job->filename) != 0)
+            error = g_strdup(g_strerror(errno));
+#ifndef WIN32
+        else
+            game_sync_dir(job->filename);
+#endif
     }
 
-    /* deal damage cause by map tiles to player */
-    damage *dam = map_tile_damage(amap, g->p->pos,
-                                  player_effect(g->p, ET_LEVITATION));
-
-    if (dam != NULL)
-        player_damage_take(g->p, dam, PD_MAP, map_tiletype_at(amap, g->p->pos));
-
-    /* move all monsters */
-    g_hash_table_foreach(g->monsters, (GHFunc)monster_move, g);
-
-    /* destroy all monsters that have been killed during this turn */
-    game_remove_dead_monsters(g);
-
-    /* move all spheres */
-    g_ptr_array_foreach(g->spheres, (GFunc)sphere_move, g);
+    if (error != NULL)
+    {
+        job->error = g_strdup_printf("Error writing save file \"%s\": %s",
+                                     job->filename, error);
+        g_free(error);
 
-    /* calculate bank interest */
-    building_bank_calc_interest(g);
+        /* the previous saved game is left untouched */
+        if (job->tmpname != NULL)
+            g_unlink(job->tmpname);
+    }
 
-    g->gtime++; /* count up the time  */
-    log_set_time(g->log, g->gtime); /* adjust time for log entries */
+    return job;
 }
 
-void game_remove_dead_monsters(game *g)
+/* take over the lock of the new file and report errors */
+static gboolean game_save_job_complete(game *g, save_job *job)
 {
-    g_assert (g != NULL);
+    gboolean success = (job->error == NULL);
 
-    while (g->dead_monsters->len > 0)
+    if (!success)
     {
-        g_ptr_array_remove_index(g->dead_monsters, g->dead_monsters->len - 1);
+        log_add_entry(g->log, "%s", job->error);
+
+        if (job->fd != -1)
+            close(job->fd);
     }
-}
+    else if (job->tmpname != NULL)
+    {
+        /* the new file has replaced the saved game, release the old one */
+        if (sgfd)
+            close(sgfd);
 
-gpointer game_item_register(game *g, item *it)
-{
-    g_assert (g != NULL && it != NULL);
+        sgfd = job->fd;
+    }
+    else
+    {
+        close(job->fd);
+    }
 
-    gpointer nkey = GUINT_TO_POINTER(++g->item_max_id);
-    g_hash_table_insert(g->items, nkey, it);
+    g_free(job->filename);
+    g_free(job->tmpname);
+    g_free(job->error);
+    g_free(job);
 
-    return nkey;
+    return success;
 }
 
-void game_item_unregister(game *g, gpointer it)
+static gpointer game_save_thread(gpointer data)
 {
-    g_assert (g != NULL && it != NULL);
-
-    g_hash_table_remove(g->items, it);
+    return game_save_job_run((save_job *)data);
 }
 
-item *game_item_get(game *g, gpointer id)
+/* wait for a background save to complete */
+static void game_save_finish(game *g)
 {
-    g_assert(g != NULL && id != NULL);
+    if (save_thread == NULL)
+        return;
 
-    return (item *)g_hash_table_lookup(g->items, id);
+    save_job *job = g_thread_join(save_thread);
+    save_thread = NULL;
+
+    game_save_job_complete(g, job);
 }
 
-gpointer game_effect_register(game *g, effect *e)
+int game_save(game *g)
+{
+    display_window *win = NULL;
+
+    g_assert(g != NULL);
+
+    /* if the display has been initialised, show a pop-up message */
+    if (display_available())
+        win = display_popup(2, 2, 0, NULL, "Saving....", 0);
+
+    /* a pending background save would interfere */
+    game_save_finish(g);
+
+    /* assemble the saved game */
+    game_serialize_binary(g);
+
+    /* write the saved game */
+    if (!game_save_job_complete(g, game_save_job_run(game_save_job_new(g))))
+        return FALSE;
+
+    /* if a pop-up message has been opened, destroy it here */
+    if (win != NULL)
+        display_window_destroy(win);
+
+    return TRUE;
+}
+
+void game_save_background(game *g)
+{
+    g_assert(g != NULL);
+
+    /* only one save may be written at a time */
+    game_save_finish(g);
+
+    /* take a snapshot of the game; this is the only part that
+       has to happen before the game can continue */
+    game_serialize_binary(g);
+
+    /* compression and writing happen in a separate thread which is
+       the only user of the chunks until it has been joined */
+    save_thread = g_thread_new("save", game_save_thread, game_save_job_new(g));
+}
+
+/* synthetic games used to time saving and loading */
+static const struct
+{
+    const char *name;
+    int maps;       /* number of maps the player has explored */
+    guint items;    /* items added to every explored map */
+    guint monsters; /* monsters added to every explored map */
+} bench_games[] =
+{
+    { "new game",  1,       0,   0 },
+    { "mid game",  7,       150, 10 },
+    { "late game", MAP_MAX, 300, 20 },
+};
+
+/* add items and monsters to the first maps and let the player remember them */
+static void game_benchmark_populate(game *g, int maps, guint items,
+                                    guint monsters)
+{
+    for (int nmap = 0; nmap < maps; nmap++)
+    {
+        map *m = g->maps[nmap];
+        position pos = pos_invalid;
+
+        m->visited = g->gtime;
+
+        for (guint idx = 0; idx < items; idx++)
+        {
+            pos = map_find_space(m, LE_ITEM, FALSE);
+
+            if (!pos_valid(pos))
+                break;
+
+            item *it = item_new_random(rand_m_n(IT_AMULET, IT_MAX), FALSE);
+            player_memory_of(g->p, pos).item = it->type;
+            player_memory_of(g->p, pos).item_colour = item_colour(it);
+
+            /* the item may be merged into another one */
+            inv_add(map_ilist_at(m, pos), it);
+        }
+
+        for (guint idx = 0; idx < monsters; idx++)
+        {
+            pos = map_find_space(m, LE_MONSTER, FALSE);
+
+            if (!pos_valid(pos))
+                break;
+
+            monster_new_by_level(pos);
+        }
+
+        /* the player has seen every tile of the map */
+        Z(pos) = nmap;
+        for (Y(pos) = 0; Y(pos) < MAP_MAX_Y; Y(pos)++)
+        {
+            for (X(pos) = 0; X(pos) < MAP_MAX_X; X(pos)++)
+            {
+                player_memory_of(g->p, pos).type = map_tiletype_at(m, pos);
+                player_memory_of(g->p, pos).sobject = map_sobject_at(m, pos);
+                player_memory_of(g->p, pos).trap = map_trap_at(m, pos);
+            }
+        }
+    }
+}
+
+/* the maximum resident set size of the process in kilobytes */
+static long game_benchmark_peak_rss()
+{
+#if (defined __unix) || (defined __unix__) || (defined __APPLE__)
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+# ifdef __APPLE__
+        return usage.ru_maxrss / 1024;
+# else
+        return usage.ru_maxrss;
+# endif
+#endif
+    return 0;
+}
+
+/* remove the benchmark's saved game and return to the user's one */
+static void game_benchmark_save_done(char *savefile)
+{
+    game_delete_savefile();
+
+    g_free(nlarn->savefile);
+    nlarn->savefile = savefile;
+}
+
+/* time saving and loading synthetic games of increasing size */
+static gboolean game_benchmark_save(int runs)
+{
+    /* do not touch the user's saved game */
+    char *savefile = nlarn->savefile;
+    nlarn->savefile = g_build_path(G_DIR_SEPARATOR_S, game_userdir(),
+                                   "bench.sav", NULL);
+
+    game_new();
+    nlarn->p->name = g_strdup("Benchmark");
+    player_map_enter(nlarn->p, game_map(nlarn, 0), FALSE);
+
+    g_printf("Saving and loading synthetic games, %d runs each, "
+             "compression level %d\n\n", runs, nlarn->compression);
+    g_printf("%-10s %5s %6s %8s %9s %9s %9s %9s %9s %9s\n",
+             "game", "maps", "items", "monsters", "data KiB", "file KiB",
+             "save ms", "load ms", "MiB/s", "peak KiB");
+
+    for (guint game = 0; game < G_N_ELEMENTS(bench_games); game++)
+    {
+        gint64 save_time = 0, load_time = 0;
+        gsize data_size = 0, file_size = 0;
+
+        /* every game builds upon the previous one */
+        game_benchmark_populate(nlarn, bench_games[game].maps,
+                                bench_games[game].items,
+                                bench_games[game].monsters);
+
+        for (int run = 0; run < runs; run++)
+        {
+            /* measure the serializers rather than the chunk cache */
+            game_save_chunks_free();
+
+            gint64 start = g_get_monotonic_time();
+
+            if (!game_save(nlarn))
+            {
+                g_printerr("Failed to write \"%s\".\n", nlarn->savefile);
+                game_benchmark_save_done(savefile);
+                return FALSE;
+            }
+
+            gint64 saved = g_get_monotonic_time();
+
+            game_clear(nlarn);
+
+            if (!game_load(nlarn->savefile, FALSE))
+            {
+                g_printerr("Failed to read \"%s\".\n", nlarn->savefile);
+                game_benchmark_save_done(savefile);
+                return FALSE;
+            }
+
+            save_time += saved - start;
+            load_time += g_get_monotonic_time() - saved;
+        }
+
+        for (int idx = 0; idx < SAVE_CHUNK_MAX; idx++)
+        {
+            data_size += save_chunks[idx].raw->len;
+            file_size += save_chunks[idx].gz->len;
+        }
+
+        /* throughput of the uncompressed data for a save and a load */
+        double seconds = (save_time + load_time) / (double)G_USEC_PER_SEC;
+
+        g_printf("%-10s %5d %6u %8u %9.1f %9.1f %9.2f %9.2f %9.1f %9ld\n",
+                 bench_games[game].name, bench_games[game].maps,
+                 g_hash_table_size(nlarn->items),
+                 g_hash_table_size(nlarn->monsters),
+                 data_size / 1024.0, file_size / 1024.0,
+                 save_time / 1000.0 / runs, load_time / 1000.0 / runs,
+                 2.0 * runs * data_size / (1024.0 * 1024.0) / seconds,
+                 game_benchmark_peak_rss());
+    }
+
+    game_benchmark_save_done(savefile);
+
+    return TRUE;
+}
+
+map *game_map(game *g, guint nmap)
+{
+    g_assert (g != NULL && nmap < MAP_MAX);
+
+    return g->maps[nmap];
+}
+
+void game_spin_the_wheel(game *g)
+{
+    map *amap;
+
+    g_assert(g != NULL);
+
+    /* add the player's speed to the player's movement points */
+    nlarn->p->movement += player_get_speed(nlarn->p);
+
+    /* per-map actions */
+    for (int nmap = 0; nmap < MAP_MAX; nmap++)
+    {
+        amap = game_map(g, nmap);
+
+        /* call map timers */
+        map_timer(amap);
+
+        /* spawn some monsters every now and then */
+        if (g->gtime % (100 + nmap) == 0)
+        {
+            map_fill_with_life(amap);
+        }
+    }
+
+    amap = game_map(nlarn, Z(g->p->pos));
+
+    /* check if player is stuck inside a wall without walk through wall */
+    if ((map_tiletype_at(amap, g->p->pos) == LT_WALL)
+            && !player_effect(g->p, ET_WALL_WALK))
+    {
+        player_die(g->p, PD_STUCK, 0);
+    }
+
+    /* check if the player is on a deep water tile without levitation */
+    if ((map_tiletype_at(amap, g->p->pos) == LT_DEEPWATER)
+            && !player_effect(g->p, ET_LEVITATION))
+    {
+        player_die(g->p, PD_DROWNED, 0);
+    }
+
+    /* check if the player is on a lava tile without levitation */
+    if ((map_tiletype_at(amap, g->p->pos) == LT_LAVA)
+            && !player_effect(g->p, ET_LEVITATION))
+    {
+        player_die(g->p, PD_MELTED, 0);
+    }
+
+    /* deal damage cause by map tiles to player */
+    damage *dam = map_tile_damage(amap, g->p->pos,
+                                  player_effect(g->p, ET_LEVITATION));
+
+    if (dam != NULL)
+        player_damage_take(g->p, dam, PD_MAP, map_tiletype_at(amap, g->p->pos));
+
+    /* move all monsters */
+    monster_plan_paths(g);
+    g_hash_table_foreach(g->monsters, (GHFunc)monster_move, g);
+
+    /* destroy all monsters that have been killed during this turn */
+    game_remove_dead_monsters(g);
+
+    /* move all spheres */
+    g_ptr_array_foreach(g->spheres, (GFunc)sphere_move, g);
+
+    /* calculate bank interest */
+    building_bank_calc_interest(g);
+
+    g->gtime++; /* count up the time  */
+    log_set_time(g->log, g->gtime); /* adjust time for log entries */
+}
+
+void game_remove_dead_monsters(game *g)
+{
+    g_assert (g != NULL);
+
+    while (g->dead_monsters->len > 0)
+    {
+        g_ptr_array_remove_index(g->dead_monsters, g->dead_monsters->len - 1);
+    }
+}
+
+gpointer game_item_register(game *g, item *it)
+{
+    g_assert (g != NULL && it != NULL);
+
+    gpointer nkey = GUINT_TO_POINTER(++g->item_max_id);
+    g_hash_table_insert(g->items, nkey, it);
+
+    return nkey;
+}
+
+void game_item_unregister(game *g, gpointer it)
+{
+    g_assert (g != NULL && it != NULL);
+
+    g_hash_table_remove(g->items, it);
+}
+
+item *game_item_get(game *g, gpointer id)
+{
+    g_assert(g != NULL && id != NULL);
+
+    return (item *)g_hash_table_lookup(g->items, id);
+}
+
+gpointer game_effect_register(game *g, effect *e)
 {
     g_assert (g != NULL && e != NULL);
 
@@ -797,97 +1367,141 @@ static void game_new()
     log_set_time(nlarn->log, nlarn->gtime);
 }
 
-static gboolean game_load()
+/*
+ * Restoring a saved game happens in two phases: the objects stored in
+ * the arrays of the saved game are decoded concurrently, as decoding
+ * one of them does not touch any shared state. The decoded objects are
+ * then added to the game one after another.
+ */
+
+/* objects that have to be decoded for a slice to get a thread of its own */
+#define RESTORE_SLICE_MIN 256
+
+typedef gpointer (*game_decode_func)(cJSON *ser);
+
+typedef struct _restore_slice
+{
+    cJSON **elements;     /* the serialized objects */
+    gpointer *results;    /* the place to store the decoded objects */
+    guint count;
+    game_decode_func decode;
+} restore_slice;
+
+static gpointer game_restore_slice(gpointer data)
+{
+    restore_slice *slice = (restore_slice *)data;
+
+    for (guint idx = 0; idx < slice->count; idx++)
+        slice->results[idx] = slice->decode(slice->elements[idx]);
+
+    return NULL;
+}
+
+/**
+ * @brief Decode all elements of a JSON array.
+ *
+ * @param the array
+ * @param the function decoding a single element
+ * @param the minimum number of elements per thread
+ * @return an array of the decoded objects in the order of the JSON array
+ */
+static GPtrArray *game_restore_array(cJSON *arr, game_decode_func decode,
+                                     guint slice_min)
 {
-    int size;
-    cJSON *save, *obj;
-    display_window *win = NULL;
+    GPtrArray *elements = g_ptr_array_new();
+    GPtrArray *results = g_ptr_array_new();
 
-    /* size of the buffer we allocate to store the uncompressed file content */
-    const int bufsize = 1024 * 1024 * 3;
+    for (cJSON *elem = (arr != NULL) ? arr->child : NULL; elem; elem = elem->next)
+        g_ptr_array_add(elements, elem);
 
-    /* try to open save file */
-    FILE* file = fopen(nlarn->savefile, "rb+");
+    g_ptr_array_set_size(results, elements->len);
 
-    if (file == NULL)
+    guint count = elements->len;
+    guint threads = CLAMP(count / slice_min, 1, g_get_num_processors());
+    guint per_slice = (count + threads - 1) / threads;
+
+    restore_slice *slices = g_new0(restore_slice, threads);
+    GThread **workers = g_new0(GThread *, threads);
+
+    for (guint t = 0; t < threads; t++)
     {
-        /* failed to open save game file */
-        return FALSE;
+        guint first = min(t * per_slice, count);
+
+        slices[t].elements = (cJSON **)elements->pdata + first;
+        slices[t].results = results->pdata + first;
+        slices[t].count = min(per_slice, count - first);
+        slices[t].decode = decode;
+
+        /* the first slice is decoded by the calling thread */
+        if (t > 0)
+            workers[t] = g_thread_new("restore", game_restore_slice, &slices[t]);
     }
 
-    /*
-     * When not on Windows, lock the save file as long the process is
-     * alive. This ensures no two instances of the game can be started
-     * from the user's saved game.
-     */
-    sgfd = try_locking_savegame_file(file);
+    game_restore_slice(&slices[0]);
 
-    /* open the file with zlib */
-    gzFile sg = gzdopen(fileno(file), "rb");
+    for (guint t = 1; t < threads; t++)
+        g_thread_join(workers[t]);
 
-    /* if the display has been initialised, show a pop-up message */
-    if (display_available())
-        win = display_popup(2, 2, 0, NULL, "Loading....", 0);
+    g_free(workers);
+    g_free(slices);
+    g_ptr_array_free(elements, TRUE);
 
-    /* temporary buffer to store uncompressed save file content */
-    char *sgbuf = g_malloc0(bufsize);
+    return results;
+}
 
-    if (!gzread(sg, sgbuf, bufsize))
-    {
-        /* Reading the file failed. Terminate the game with an error message */
-        display_shutdown();
-        g_printerr("Failed to restore save file \"%s\".\n", nlarn->savefile);
+static void game_effect_restore(gpointer e, gpointer g)
+{
+    guint oid = GPOINTER_TO_UINT(((effect *)e)->oid);
 
-        exit(EXIT_FAILURE);
-    }
+    g_hash_table_insert(((game *)g)->effects, ((effect *)e)->oid, e);
 
-    /* close save file */
-    gzclose(sg);
+    /* increase max_id to match used ids */
+    if (((game *)g)->effect_max_id < oid)
+        ((game *)g)->effect_max_id = oid;
+}
 
-    /* parse save file */
-    save = cJSON_Parse(sgbuf);
+static void game_item_restore(gpointer it, gpointer g)
+{
+    guint oid = GPOINTER_TO_UINT(((item *)it)->oid);
 
-    /* throw away the buffer */
-    g_free(sgbuf);
+    g_hash_table_insert(((game *)g)->items, ((item *)it)->oid, it);
 
-    /* check for save file incompatibility */
-    gboolean compatible_version = FALSE;
-    if (cJSON_GetObjectItem(save, "nlarn_version"))
-    {
-        nlarn->version = cJSON_GetObjectItem(save, "nlarn_version")->valueint;
+    /* increase max_id to match used ids */
+    if (((game *)g)->item_max_id < oid)
+        ((game *)g)->item_max_id = oid;
+}
 
-        if (nlarn->version == SAVEFILE_VERSION)
-            compatible_version = TRUE;
-    }
+static void game_monster_restore(gpointer m, gpointer g)
+{
+    guint oid = GPOINTER_TO_UINT(monster_oid(m));
 
-    /* handle incompatible save file */
-    if (!compatible_version)
-    {
-        /* free the memory allocated by loading the save file */
-        cJSON_Delete(save);
+    g_hash_table_insert(((game *)g)->monsters, monster_oid(m), m);
 
-        /* if a pop-up message has been opened, destroy it here */
-        if (win != NULL)
-            display_window_destroy(win);
+    /* increase max_id to match used ids */
+    if (((game *)g)->monster_max_id < oid)
+        ((game *)g)->monster_max_id = oid;
 
-        /* offer to delete the incompatible save game */
-        if (display_get_yesno("Saved game could not be loaded. "
-                    "Delete and start new game?", NULL, NULL, NULL))
-        {
-            /* delete save file */
-            g_unlink(nlarn->savefile);
-        }
-        else
-        {
-            display_shutdown();
-            g_printerr("Save file \"%s\" is not compatible to current version.\n",
-                    nlarn->savefile);
+    /* increment the count of monsters of the map the monster is on */
+    game_map(g, Z(monster_pos(m)))->mcount++;
+}
 
-            exit(EXIT_FAILURE);
-        }
+/**
+ * @brief Decode a JSON array and add the decoded objects to the game.
+ */
+static void game_restore_objects(cJSON *arr, game_decode_func decode,
+                                 GFunc add)
+{
+    GPtrArray *objects = game_restore_array(arr, decode, RESTORE_SLICE_MIN);
 
-        return FALSE;
-    }
+    g_ptr_array_foreach(objects, add, nlarn);
+    g_ptr_array_free(objects, TRUE);
+}
+
+static gboolean game_restore(cJSON *save, savefile_stream *s)
+{
+    int size;
+    cJSON *obj;
+    savefile_reader section;
 
     /* restore saved game */
     nlarn->time_start = cJSON_GetObjectItem(save, "time_start")->valueint;
@@ -962,25 +1576,41 @@ static gboolean game_load()
 
     /* restore effects (have to come first) */
     nlarn->effects = g_hash_table_new(&g_direct_hash, &g_direct_equal);
-    obj = cJSON_GetObjectItem(save, "effects");
-
-    for (int idx = 0; idx < cJSON_GetArraySize(obj); idx++)
-        effect_deserialize(cJSON_GetArrayItem(obj, idx), nlarn);
+    game_restore_objects(cJSON_GetObjectItem(save, "effects"),
+                         (game_decode_func)effect_deserialize,
+                         game_effect_restore);
 
 
     /* restore items */
     nlarn->items = g_hash_table_new(&g_direct_hash, &g_direct_equal);
-    obj = cJSON_GetObjectItem(save, "items");
-    for (int idx = 0; idx < cJSON_GetArraySize(obj); idx++)
-        item_deserialize(cJSON_GetArrayItem(obj, idx), nlarn);
+    game_restore_objects(cJSON_GetObjectItem(save, "items"),
+                         (game_decode_func)item_deserialize,
+                         game_item_restore);
 
 
-    /* restore maps */
-    obj = cJSON_GetObjectItem(save, "maps");
-    size = cJSON_GetArraySize(obj);
-    g_assert(size == MAP_MAX);
-    for (int idx = 0; idx < size; idx++)
-        nlarn->maps[idx] = map_deserialize(cJSON_GetArrayItem(obj, idx));
+    /* restore maps (binary saved games store them in separate sections) */
+    if (s != NULL)
+    {
+        for (int idx = 0; idx < MAP_MAX; idx++)
+        {
+            if (!sf_stream_section(s, SFS_MAP, &section)
+                    || !(nlarn->maps[idx] = map_deserialize_binary(&section))
+                    || section.error)
+                return FALSE;
+        }
+    }
+    else
+    {
+        /* every map is worth a thread of its own */
+        GPtrArray *maps = game_restore_array(cJSON_GetObjectItem(save, "maps"),
+                                             (game_decode_func)map_deserialize, 1);
+
+        g_assert(maps->len == MAP_MAX);
+        for (int idx = 0; idx < MAP_MAX; idx++)
+            nlarn->maps[idx] = g_ptr_array_index(maps, idx);
+
+        g_ptr_array_free(maps, TRUE);
+    }
 
 
     /* restore dnd store stock */
@@ -1002,13 +1632,25 @@ static gboolean game_load()
     /* restore player */
     nlarn->p = player_deserialize(cJSON_GetObjectItem(save, "player"));
 
+    /* restore the player's memory of the maps; the first revision
+       of the binary format stored all maps in a single section */
+    for (int idx = 0; s != NULL && idx < MAP_MAX; idx++)
+    {
+        if ((idx == 0 || s->format > 1)
+                && !sf_stream_section(s, SFS_MEMORY, &section))
+            return FALSE;
+
+        if (!player_memory_deserialize_binary(nlarn->p, idx, &section,
+                                              s->format))
+            return FALSE;
+    }
+
 
     /* restore monsters */
     nlarn->monsters = g_hash_table_new(&g_direct_hash, &g_direct_equal);
-    obj = cJSON_GetObjectItem(save, "monsters");
-
-    for (int idx = 0; idx < cJSON_GetArraySize(obj); idx++)
-        monster_deserialize(cJSON_GetArrayItem(obj, idx), nlarn);
+    game_restore_objects(cJSON_GetObjectItem(save, "monsters"),
+                         (game_decode_func)monster_deserialize,
+                         game_monster_restore);
 
     /* initialize the array to store monsters that died during the turn */
     nlarn->dead_monsters = g_ptr_array_new_with_free_func(
@@ -1024,21 +1666,173 @@ static gboolean game_load()
             sphere_deserialize(cJSON_GetArrayItem(obj, idx), nlarn);
     }
 
-    /* free parsed save game */
-    cJSON_Delete(save);
+    if (s != NULL && !sf_stream_section(s, SFS_END, &section))
+        return FALSE;
 
     /* set log turn number to current game turn number */
     log_set_time(nlarn->log, nlarn->gtime);
 
-    /* welcome message */
-    print_welcome_message(FALSE);
-
-    /* refresh FOV */
-    player_update_fov(nlarn->p);
-
     /* no need to define the player's stats */
     nlarn->player_stats_set = TRUE;
 
+    return TRUE;
+}
+
+static gboolean game_load(const char *filename, gboolean lock)
+{
+    int len;
+    cJSON *save = NULL;
+    GByteArray *sgbuf = NULL; /* the text the parsed JSON points into */
+    guint8 header[SAVEFILE_HEADER_LEN];
+    savefile_stream stream = { NULL, NULL, 0 }, *s = NULL;
+    display_window *win = NULL;
+
+    /* try to open save file */
+    FILE* file = fopen(filename, lock ? "rb+" : "rb");
+
+    if (file == NULL)
+    {
+        /* failed to open save game file */
+        return FALSE;
+    }
+
+    /*
+     * When not on Windows, lock the save file as long the process is
+     * alive. This ensures no two instances of the game can be started
+     * from the user's saved game.
+     */
+    if (lock)
+        sgfd = try_locking_savegame_file(file);
+
+    /* open the file with zlib */
+    gzFile sg = gzdopen(fileno(file), "rb");
+
+    /* if the display has been initialised, show a pop-up message */
+    if (display_available())
+        win = display_popup(2, 2, 0, NULL, "Loading....", 0);
+
+    /* read the beginning of the file to determine its format */
+    if ((len = gzread(sg, header, SAVEFILE_HEADER_LEN)) <= 0)
+    {
+        /* Reading the file failed. Terminate the game with an error message */
+        display_shutdown();
+        g_printerr("Failed to restore save file \"%s\".\n", filename);
+
+        exit(EXIT_FAILURE);
+    }
+
+    if (sf_is_binary(header, len))
+    {
+        /* binary saved game: the game data is stored as JSON in the first
+           section, followed by the maps and the player's memory. The
+           sections are inflated and restored one after another. */
+        savefile_reader section;
+
+        stream.file = sg;
+        stream.buf = g_byte_array_new();
+        stream.format = header[SAVEFILE_MAGIC_LEN];
+        s = &stream;
+
+        if (stream.format >= 1 && stream.format <= SAVEFILE_FORMAT
+                && sf_stream_section(s, SFS_GAME, &section)
+                && section.len > 0
+                && section.data[section.len - 1] == '\0')
+        {
+            /* keep the section buffer with the parsed document and
+               read the remaining sections into a new one */
+            sgbuf = stream.buf;
+            stream.buf = g_byte_array_new();
+
+            save = cJSON_ParseInSitu((char *)sgbuf->data);
+        }
+    }
+    else
+    {
+        /* JSON saved game: inflate the whole document */
+        guint8 chunk[16384];
+
+        sgbuf = g_byte_array_new();
+
+        g_byte_array_append(sgbuf, header, len);
+
+        while ((len = gzread(sg, chunk, sizeof(chunk))) > 0)
+            g_byte_array_append(sgbuf, chunk, len);
+
+        g_byte_array_append(sgbuf, (const guint8 *)"", 1);
+
+        /* parse save file */
+        save = cJSON_ParseInSitu((char *)sgbuf->data);
+    }
+
+    /* check for save file incompatibility */
+    gboolean compatible_version = FALSE;
+    if (cJSON_GetObjectItem(save, "nlarn_version"))
+    {
+        nlarn->version = cJSON_GetObjectItem(save, "nlarn_version")->valueint;
+
+        if (nlarn->version == SAVEFILE_VERSION)
+            compatible_version = TRUE;
+    }
+
+    /* handle incompatible save file */
+    if (!compatible_version)
+    {
+        /* free the memory allocated by loading the save file */
+        cJSON_Delete(save);
+        if (sgbuf != NULL)
+            g_byte_array_free(sgbuf, TRUE);
+        if (stream.buf != NULL)
+            g_byte_array_free(stream.buf, TRUE);
+
+        /* close save file */
+        gzclose(sg);
+
+        /* if a pop-up message has been opened, destroy it here */
+        if (win != NULL)
+            display_window_destroy(win);
+
+        /* offer to delete the incompatible save game */
+        if (lock && display_available()
+                && display_get_yesno("Saved game could not be loaded. "
+                    "Delete and start new game?", NULL, NULL, NULL))
+        {
+            /* delete save file */
+            g_unlink(filename);
+        }
+        else
+        {
+            display_shutdown();
+            g_printerr("Save file \"%s\" is not compatible to current version.\n",
+                    filename);
+
+            exit(EXIT_FAILURE);
+        }
+
+        return FALSE;
+    }
+
+    /* restore saved game */
+    gboolean restored = game_restore(save, s);
+
+    /* free parsed save game and the buffers */
+    cJSON_Delete(save);
+    if (sgbuf != NULL)
+        g_byte_array_free(sgbuf, TRUE);
+    if (stream.buf != NULL)
+        g_byte_array_free(stream.buf, TRUE);
+
+    /* close save file */
+    gzclose(sg);
+
+    if (!restored)
+    {
+        /* The save file is truncated or corrupted. */
+        display_shutdown();
+        g_printerr("Failed to restore save file \"%s\".\n", filename);
+
+        exit(EXIT_FAILURE);
+    }
+
     /* if a pop-up message has been opened, destroy it here */
     if (win != NULL)
         display_window_destroy(win);
@@ -1057,6 +1851,9 @@ static void game_items_shuffle(game *g)
 
 void game_delete_savefile()
 {
+    /* the file must not be written to anymore */
+    game_save_finish(nlarn);
+
     if (sgfd == 0)
     {
         /* no savegame present */
@@ -1068,11 +1865,6 @@ void game_delete_savefile()
     close(sgfd);
     sgfd = 0;
 
-    /* assemble save file name */
-    char *fullname = g_build_path(G_DIR_SEPARATOR_S, game_userdir(),
-            save_file, NULL);
-
     /* actually delete the file */
-    g_unlink(fullname);
-    g_free(fullname);
+    g_unlink(nlarn->savefile);
 }
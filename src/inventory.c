@@ -92,6 +92,29 @@ inventory *inv_deserialize(cJSON *iser)
     return inv;
 }
 
+void inv_serialize_oids(inventory *inv, GByteArray *buf)
+{
+    for (guint idx = 0; idx < inv_length(inv); idx++)
+    {
+        /* the inventory stores the oids, no need to look up the items */
+        sf_put_u32(buf, GPOINTER_TO_UINT(g_ptr_array_index(inv->content, idx)));
+    }
+}
+
+inventory *inv_deserialize_oids(savefile_reader *r, guint count)
+{
+    inventory *inv = g_malloc0(sizeof(inventory));
+    inv->content = g_ptr_array_sized_new(count);
+
+    for (guint idx = 0; idx < count; idx++)
+    {
+        guint oid = sf_get_u32(r);
+        g_ptr_array_add(inv->content, GUINT_TO_POINTER(oid));
+    }
+
+    return inv;
+}
+
 void inv_callbacks_set(inventory *inv, inv_callback_bool pre_add,
                        inv_callback_void post_add, inv_callback_bool pre_del,
                        inv_callback_void post_del)
@@ -511,17 +511,15 @@ void item_serialize(gpointer oid, gpointer it, gpointer root)
     }
 }
 
-item *item_deserialize(cJSON *iser, struct game *g)
+item *item_deserialize(cJSON *iser)
 {
-    guint oid;
     item *it;
     cJSON *obj;
 
     it = g_malloc0(sizeof(item));
 
     /* must-have attributes */
-    oid = cJSON_GetObjectItem(iser, "oid")->valueint;
-    it->oid = GUINT_TO_POINTER(oid);
+    it->oid = GUINT_TO_POINTER(cJSON_GetObjectItem(iser, "oid")->valueint);
 
     it->type = cJSON_GetObjectItem(iser, "type")->valueint;
     it->id = cJSON_GetObjectItem(iser, "id")->valueint;
@@ -565,13 +563,6 @@ item *item_deserialize(cJSON *iser, struct game *g)
     obj = cJSON_GetObjectItem(iser, "effects");
     if (obj != NULL) it->effects = effects_deserialize(obj);
 
-    /* add item to game */
-    g_hash_table_insert(g->items, it->oid, it);
-
-    /* increase max_id to match used ids */
-    if (g->item_max_id < oid)
-        g->item_max_id = oid;
-
     return it;
 }
 
@@ -39,18 +39,42 @@ static void map_make_river(map *m, map_tile_t rivertype);
 static void map_make_lake(map *m, map_tile_t laketype);
 static void map_make_treasure_room(map *m, rectangle **rooms);
 static int map_validate(map *m);
+static void map_transparency_update(map *m);
 
 static map_path *map_path_new(position start, position goal);
-static map_path_element *map_path_element_new(position pos);
+static void map_path_add_step(map_path *path, map_path_element *el);
+static map_path_element *map_path_element_at(map_path *path, position pos);
 static int map_step_cost(map *m, map_path_element* element,
                          map_element_t map_elem, gboolean ppath);
-static int map_path_cost(map_path_element* element, position target);
-static map_path_element *map_path_element_in_list(map_path_element* el,
-                                                  GPtrArray *list);
-static map_path_element *map_path_find_best(map_path *path);
-static GPtrArray *map_path_get_neighbours(map *m, position pos,
-                                          map_element_t element,
-                                          gboolean ppath);
+static int map_tile_penalty(map_tile_t tt, map_element_t map_elem);
+static int map_trap_penalty(map *m, position pos);
+static struct map_dmap *map_dmap_to_player(map *m, map_element_t element);
+static struct map_dmap *map_dmap_from_player(map *m, map_element_t element);
+static position map_dmap_step(map *m, struct map_dmap *dm, position pos,
+                              map_element_t element, gboolean *lowest);
+static map_path *map_find_path_across(map *m, position start, position goal,
+                                      map_element_t element);
+static gboolean map_path_uniform(map *m, map_path *path,
+                                 map_element_t element, gboolean ppath);
+static map_path *map_find_path_jps(map_path *path);
+static gboolean map_pos_connected(map *m, position start, position goal,
+                                  map_element_t element);
+static gboolean map_route_plan(map_route *route, map *m, position pos,
+                               position goal, guint keep, gboolean ppath);
+static gboolean map_route_step_intact(map *m, map_route_step *step,
+                                      map_element_t element, gboolean ppath);
+static position map_path_first_step(map *m, position start, position goal,
+                                    map_element_t element, gint32 *cost);
+static int map_path_query_cmp(const void *a, const void *b);
+static gboolean map_path_query_same_goal(map_path_query *a, map_path_query *b);
+static gpointer map_paths_solve(gpointer data);
+static struct map_areas *map_areas_get(map *m, map_element_t element);
+static void map_path_open_push(map_path *path, map_path_element *el);
+static map_path_element *map_path_open_pop(map_path *path);
+static void map_path_open_update(map_path *path, map_path_element *el);
+static int map_path_get_neighbours(map *m, position pos,
+                                   map_element_t element,
+                                   gboolean ppath, position *neighbours);
 
 static inline void map_sphere_destroy(sphere *s, map *m __attribute__((unused)))
 {
@@ -77,6 +101,71 @@ const map_tile_data map_tiles[LT_MAX] =
 /* keep track which levels have been used before */
 static int map_used[MAP_MAZE_NUM + 1] = { 1, 0 };
 
+/*
+ * Distance maps hold the cost of the cheapest way from every position of
+ * a map to a set of goals. Monsters are not taken into account as they
+ * move while the map is being used.
+ */
+#define MAP_DMAP_UNREACHABLE G_MAXINT32
+
+typedef struct map_dmap
+{
+    gint32 dist[MAP_MAX_Y][MAP_MAX_X];
+    position goal;      /* the goal the distances have been determined for */
+    guint32 revision;   /* the revision of the map at that time */
+    gboolean valid;
+} map_dmap;
+
+static inline gint32 map_dmap_at(map_dmap *dm, position pos)
+{
+    return dm->dist[Y(pos)][X(pos)];
+}
+
+/*
+ * Lines of sight from every position of a map to a single target. They
+ * only depend on the transparency of the tiles, thus they stay valid
+ * until the target moves or the map changes.
+ */
+typedef enum map_los_state
+{
+    MAP_LOS_UNKNOWN,
+    MAP_LOS_VISIBLE,
+    MAP_LOS_BLOCKED
+} map_los_state;
+
+typedef struct map_los
+{
+    guint8 sight[MAP_MAX_Y][MAP_MAX_X]; /* map_los_state per source */
+    position target;    /* the target the lines of sight lead to */
+    guint32 revision;   /* the revision of the map at that time */
+    gboolean valid;
+} map_los;
+
+/* memory for a path search; the path has to come first */
+typedef struct _map_path_storage
+{
+    map_path path;
+    GQueue steps;
+    GList links[MAP_SIZE];
+    map_path_element nodes[MAP_SIZE];
+    map_path_element *open[MAP_SIZE];
+    gboolean free[MAP_MAX_Y + 2][MAP_MAX_X + 2]; /* enterable positions with a
+                                                   blocked border, used by
+                                                   jump point search */
+} map_path_storage;
+
+/* Path searches are frequent: monsters search for a path every turn and
+   so does the player while travelling. This storage is reused by one
+   search after another, thus searching does not allocate memory. */
+static map_path_storage path_storage;
+static gint path_storage_used = FALSE;
+
+/* use jump point search where possible */
+static gboolean path_jps = TRUE;
+
+/* the minimum distance between start and goal for jump point search */
+#define MAP_PATH_JPS_MIN 8
+
 const char *map_names[MAP_MAX] =
 {
     "Town",
@@ -161,6 +250,8 @@ map *map_new(int num, char *mazefile)
         while (!keep_maze);
     }
 
+    map_transparency_update(nmap);
+
     if (num != 0)
     {
         /* home town is not filled with crap */
@@ -176,6 +267,23 @@ map *map_new(int num, char *mazefile)
     return nmap;
 }
 
+map *map_new_maze(int num, char *mazefile, guint which)
+{
+    map *nmap = nlarn->maps[num] = g_malloc0(sizeof(map));
+    nmap->nlevel = num;
+
+    if (!map_load_from_file(nmap, mazefile, which))
+    {
+        map_destroy(nmap);
+        return nlarn->maps[num] = NULL;
+    }
+
+    map_transparency_update(nmap);
+    map_fill_with_life(nmap);
+
+    return nmap;
+}
+
 cJSON *map_serialize(map *m)
 {
     cJSON *mser, *grid, *tile;
@@ -277,6 +385,105 @@ map *map_deserialize(cJSON *mser)
         }
     }
 
+    map_transparency_update(m);
+
+    return m;
+}
+
+/* size of a single tile in binary saved games:
+   type, base_type, sobject, trap, timer, (unused),
+   item count (16 bit), monster oid (32 bit) */
+#define MAP_TILE_RECORD_LEN 12
+
+void map_serialize_binary(map *m, GByteArray *buf)
+{
+    sf_put_u8(buf, m->nlevel);
+    sf_put_u32(buf, m->visited);
+
+    /* fixed-width tile records */
+    for (int y = 0; y < MAP_MAX_Y; y++)
+    {
+        for (int x = 0; x < MAP_MAX_X; x++)
+        {
+            map_tile *tile = &m->grid[y][x];
+            guint8 rec[MAP_TILE_RECORD_LEN] = { 0 };
+            guint32 oid = GPOINTER_TO_UINT(tile->m_oid);
+            guint icount = inv_length(tile->ilist);
+
+            g_assert(icount <= G_MAXUINT16);
+
+            rec[0] = tile->type;
+            rec[1] = tile->base_type;
+            rec[2] = tile->sobject;
+            rec[3] = tile->trap;
+            rec[4] = tile->timer;
+            rec[6] = icount & 0xff;
+            rec[7] = icount >> 8;
+            rec[8] = oid & 0xff;
+            rec[9] = (oid >> 8) & 0xff;
+            rec[10] = (oid >> 16) & 0xff;
+            rec[11] = oid >> 24;
+
+            sf_put_data(buf, rec, MAP_TILE_RECORD_LEN);
+        }
+    }
+
+    /* the oids of the items on the map in the order of the tiles */
+    for (int y = 0; y < MAP_MAX_Y; y++)
+        for (int x = 0; x < MAP_MAX_X; x++)
+            inv_serialize_oids(m->grid[y][x].ilist, buf);
+}
+
+map *map_deserialize_binary(savefile_reader *r)
+{
+    const guint8 *rec;
+    guint16 icount[MAP_MAX_Y][MAP_MAX_X];
+    map *m = g_malloc0(sizeof(map));
+
+    m->nlevel = sf_get_u8(r);
+    m->visited = sf_get_u32(r);
+
+    if (m->nlevel >= MAP_MAX
+            || !(rec = sf_get_data(r, MAP_SIZE * MAP_TILE_RECORD_LEN)))
+    {
+        g_free(m);
+        return NULL;
+    }
+
+    for (int y = 0; y < MAP_MAX_Y; y++)
+    {
+        for (int x = 0; x < MAP_MAX_X; x++, rec += MAP_TILE_RECORD_LEN)
+        {
+            map_tile *tile = &m->grid[y][x];
+
+            /* the values are used as indices into the tables of tiles,
+               stationary objects and traps */
+            if (rec[0] >= LT_MAX || rec[1] >= LT_MAX
+                    || rec[2] >= LS_MAX || rec[3] >= TT_MAX)
+            {
+                g_free(m);
+                return NULL;
+            }
+
+            tile->type = rec[0];
+            tile->base_type = rec[1];
+            tile->sobject = rec[2];
+            tile->trap = rec[3];
+            tile->timer = rec[4];
+            icount[y][x] = rec[6] | rec[7] << 8;
+            tile->m_oid = GUINT_TO_POINTER(rec[8] | rec[9] << 8
+                                           | rec[10] << 16
+                                           | (guint32)rec[11] << 24);
+        }
+    }
+
+    for (int y = 0; y < MAP_MAX_Y; y++)
+        for (int x = 0; x < MAP_MAX_X; x++)
+            if (icount[y][x] > 0)
+                m->grid[y][x].ilist = inv_deserialize_oids(r, icount[y][x]);
+
+    map_transparency_update(m);
+
     return m;
 }
 
@@ -345,6 +552,18 @@ void map_destroy(map *m)
                 inv_destroy(m->grid[y][x].ilist, TRUE);
         }
 
+    for (int idx = 0; idx < LE_MAX; idx++)
+    {
+        g_free(m->dmaps[idx]);
+        g_free(m->safety[idx]);
+        g_free(m->exits[idx]);
+        g_free(m->areas[idx]);
+    }
+
+    if (m->moves != NULL)
+        g_array_free(m->moves, TRUE);
+
+    g_free(m->los);
     g_free(m);
 }
 
@@ -570,8 +789,7 @@ int map_pos_is_visible(map *m, position s, position t)
             x += ix;
             error += delta_y;
 
-            if (!mt_is_transparent(m->grid[y][x].type)
-                    || !so_is_transparent(m->grid[y][x].sobject))
+            if (!map_xy_transparent(m, x, y))
             {
                 return FALSE;
             }
@@ -596,8 +814,7 @@ int map_pos_is_visible(map *m, position s, position t)
             y += iy;
             error += delta_x;
 
-            if (!mt_is_transparent(m->grid[y][x].type)
-                    || !so_is_transparent(m->grid[y][x].sobject))
+            if (!map_xy_transparent(m, x, y))
             {
                 return FALSE;
             }
@@ -607,6 +824,39 @@ int map_pos_is_visible(map *m, position s, position t)
     return TRUE;
 }
 
+int map_pos_is_visible_cached(map *m, position source, position target)
+{
+    /* positions on different levels? */
+    if (Z(source) != Z(target))
+        return FALSE;
+
+    if (m->los == NULL)
+        m->los = g_malloc0(sizeof(map_los));
+
+    map_los *los = m->los;
+
+    if (!los->valid || los->revision != m->revision
+            || !pos_identical(los->target, target))
+    {
+        /* forget the lines of sight to the previous target */
+        memset(los->sight, MAP_LOS_UNKNOWN, sizeof(los->sight));
+
+        los->target = target;
+        los->revision = m->revision;
+        los->valid = TRUE;
+    }
+
+    guint8 *sight = &los->sight[Y(source)][X(source)];
+
+    if (*sight == MAP_LOS_UNKNOWN)
+    {
+        *sight = map_pos_is_visible(m, source, target)
+                 ? MAP_LOS_VISIBLE : MAP_LOS_BLOCKED;
+    }
+
+    return (*sight == MAP_LOS_VISIBLE);
+}
+
 map_path *map_find_path(map *m, position start, position goal,
                         map_element_t element)
 {
@@ -614,29 +864,36 @@ map_path *map_find_path(map *m, position start, position goal,
 
     map_path *path;
     map_path_element *curr, *next;
-    gboolean next_is_better;
+    position neighbours[GD_MAX];
 
-    /* if the starting position is on another map, fail for now */
-    /* TODO: could be changed to support 3D path finding */
+    /* the goal is on another map: find the way to the map exit */
     if (Z(start) != Z(goal))
+        return map_find_path_across(m, start, goal, element);
+
+    /* check if the path is being determined for the player */
+    gboolean ppath = pos_identical(start, nlarn->p->pos);
+
+    /* the player's knowledge of the map may differ from the map,
+       for everybody else there is no way into another area */
+    if (!ppath && !map_pos_connected(m, start, goal, element))
         return NULL;
 
     path = map_path_new(start, goal);
 
+    /* jump point search pays off for longer ways only */
+    if (path_jps && pos_distance(start, goal) >= MAP_PATH_JPS_MIN
+            && map_path_uniform(m, path, element, ppath))
+        return map_find_path_jps(path);
+
     /* add start to open list */
-    curr = map_path_element_new(start);
+    curr = map_path_element_at(path, start);
     curr->g_score = 0; /* no distance yet */
-    g_ptr_array_add(path->open, curr);
-
-    /* check if the path is being determined for the player */
-    gboolean ppath = pos_identical(start, nlarn->p->pos);
+    map_path_open_push(path, curr);
 
-    while (path->open->len)
+    while (path->open_len)
     {
-        curr = map_path_find_best(path);
-
-        g_ptr_array_remove_fast(path->open, curr);
-        g_ptr_array_add(path->closed, curr);
+        curr = map_path_open_pop(path);
+        curr->state = MAP_PATH_CLOSED;
 
         if (pos_identical(curr->pos, path->goal))
         {
@@ -647,7 +904,7 @@ map_path *map_find_path(map *m, position start, position goal,
             {
                 /* don't need the starting point in the path */
                 if (curr->parent != NULL)
-                    g_queue_push_head(path->path, curr);
+                    map_path_add_step(path, curr);
 
                 curr = curr->parent;
             }
@@ -656,47 +913,34 @@ map_path *map_find_path(map *m, position start, position goal,
             return path;
         }
 
-        GPtrArray *neighbours = map_path_get_neighbours(m, curr->pos, element, ppath);
+        int count = map_path_get_neighbours(m, curr->pos, element, ppath,
+                                            neighbours);
 
-        while (neighbours->len)
+        for (int idx = 0; idx < count; idx++)
         {
-            next = g_ptr_array_remove_index_fast(neighbours,
-                                                 neighbours->len - 1);
-
-            next_is_better = FALSE;
+            next = map_path_element_at(path, neighbours[idx]);
 
-            if (map_path_element_in_list(next, path->closed))
-            {
-                g_free(next);
+            if (next->state == MAP_PATH_CLOSED)
                 continue;
-            }
 
             const guint32 next_g_score =
                 curr->g_score
                 + map_step_cost(m, next, element, ppath);
 
-            if (!map_path_element_in_list(next, path->open))
+            if (next->state == MAP_PATH_NEW)
             {
-                g_ptr_array_add(path->open, next);
-                next_is_better = TRUE;
+                next->parent  = curr;
+                next->g_score = next_g_score;
+                map_path_open_push(path, next);
             }
             else if (next->g_score > next_g_score)
             {
-                next_is_better = TRUE;
-            }
-            else
-            {
-                g_free(next);
-            }
-
-            if (next_is_better)
-            {
+                /* found a shorter way to an open element */
                 next->parent  = curr;
                 next->g_score = next_g_score;
+                map_path_open_update(path, next);
             }
         }
-
-        g_ptr_array_free(neighbours, TRUE);
     }
 
     /* could not find a path */
@@ -705,28 +949,304 @@ map_path *map_find_path(map *m, position start, position goal,
     return NULL;
 }
 
+void map_path_jps_set(gboolean enable)
+{
+    path_jps = enable;
+}
+
 void map_path_destroy(map_path *path)
 {
     g_assert(path != NULL);
 
-    /* clean up open list */
-    for (guint idx = 0; idx < path->open->len; idx++)
+    if (path == &path_storage.path)
+    {
+        /* the shared storage can be used by the next search */
+        g_atomic_int_set(&path_storage_used, FALSE);
+    }
+    else
+    {
+        g_free(path);
+    }
+}
+
+/* minimum number of goals for each thread solving a batch of path queries */
+#define MAP_PATHS_SLICE_MIN 16
+
+typedef struct _map_paths_slice
+{
+    map *m;
+    map_path_query **queries; /* all queries of the goals of this slice */
+    guint count;
+} map_paths_slice;
+
+void map_find_paths(map *m, map_path_query *queries, guint count)
+{
+    g_assert(m != NULL && (queries != NULL || count == 0));
+
+    GPtrArray *batch = g_ptr_array_sized_new(count);
+    gboolean warm[LE_MAX] = { FALSE };
+
+    /* record the monsters moving from now on for map_path_query_current() */
+    if (m->moves == NULL)
+        m->moves = g_array_new(FALSE, FALSE, sizeof(position));
+
+    g_array_set_size(m->moves, 0);
+
+    for (guint idx = 0; idx < count; idx++)
     {
-        g_free(g_ptr_array_index(path->open, idx));
+        map_path_query *q = &queries[idx];
+
+        g_assert(Z(q->start) == m->nlevel);
+
+        q->revision = m->revision;
+
+        if (Z(q->goal) != m->nlevel)
+        {
+            /* ways across maps update the caches of other maps; the
+               cost of the way to the exit does not tell which monsters
+               could affect the way beyond */
+            q->step = map_path_first_step(m, q->start, q->goal, q->element,
+                                          &q->cost);
+            q->cost = MAP_DMAP_UNREACHABLE;
+            continue;
+        }
+
+        /* the connected areas are read by all threads, thus they
+           have to be up to date before the threads are started */
+        if (!warm[q->element])
+        {
+            map_areas_get(m, q->element);
+            warm[q->element] = TRUE;
+        }
+
+        g_ptr_array_add(batch, q);
+    }
+
+    /* queries with the same goal have to be adjacent */
+    qsort(batch->pdata, batch->len, sizeof(gpointer), map_path_query_cmp);
+
+    guint goals = 0;
+    for (guint idx = 0; idx < batch->len; idx++)
+    {
+        if (idx == 0 || !map_path_query_same_goal(g_ptr_array_index(batch, idx - 1),
+                                                  g_ptr_array_index(batch, idx)))
+            goals++;
+    }
+
+    guint threads = CLAMP(goals / MAP_PATHS_SLICE_MIN, 1, g_get_num_processors());
+    guint per_slice = (goals + threads - 1) / threads;
+
+    map_paths_slice *slices = g_new0(map_paths_slice, threads);
+    GThread **workers = g_new0(GThread *, threads);
+
+    /* split the queries between the slices without separating a goal */
+    for (guint idx = 0, t = 0, slice_goals = 0; idx < batch->len; idx++)
+    {
+        if (idx == 0 || !map_path_query_same_goal(g_ptr_array_index(batch, idx - 1),
+                                                  g_ptr_array_index(batch, idx)))
+        {
+            if (slice_goals == per_slice)
+            {
+                t++;
+                slice_goals = 0;
+            }
+
+            slice_goals++;
+        }
+
+        if (slices[t].queries == NULL)
+            slices[t].queries = (map_path_query **)batch->pdata + idx;
+
+        slices[t].count++;
+    }
+
+    for (guint t = 0; t < threads; t++)
+    {
+        slices[t].m = m;
+
+        /* the first slice is solved by the calling thread */
+        if (t > 0)
+            workers[t] = g_thread_new("paths", map_paths_solve, &slices[t]);
+    }
+
+    map_paths_solve(&slices[0]);
+
+    for (guint t = 1; t < threads; t++)
+        g_thread_join(workers[t]);
+
+    g_free(workers);
+    g_free(slices);
+    g_ptr_array_free(batch, TRUE);
+}
+
+/* the number of steps between two positions of a map */
+static inline gint32 map_chebyshev(position a, position b)
+{
+    return max(abs(X(a) - X(b)), abs(Y(a) - Y(b)));
+}
+
+gboolean map_path_query_current(map *m, map_path_query *q)
+{
+    g_assert(m != NULL && q != NULL);
+
+    if (q->revision != m->revision || m->moves == NULL)
+        return FALSE;
+
+    /* Every step costs at least 1, thus a way through a position costs at
+       least the number of steps to reach the position and the goal from
+       there. Positions farther away do not affect the cheapest ways. */
+    for (guint idx = 0; idx < m->moves->len; idx++)
+    {
+        position pos = g_array_index(m->moves, position, idx);
+
+        if (q->cost == MAP_DMAP_UNREACHABLE
+                || map_chebyshev(q->start, pos) + map_chebyshev(pos, q->goal)
+                   <= q->cost)
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+map_route *map_route_new(position goal, map_element_t element)
+{
+    map_route *route = g_malloc0(sizeof(map_route));
+
+    route->steps = g_array_new(FALSE, FALSE, sizeof(map_route_step));
+    route->goal = goal;
+    route->last = pos_invalid;
+    route->element = element;
+
+    return route;
+}
+
+position map_route_next(map_route *route, map *m, position pos)
+{
+    g_assert(route != NULL && m != NULL && pos_valid(pos));
+
+    const gboolean ppath = pos_identical(pos, nlarn->p->pos);
+    GArray *steps = route->steps;
+
+    if (!pos_identical(pos, route->last))
+    {
+        /* the traveller has left the route; start over */
+        if (!map_route_plan(route, m, pos, route->goal, 0, ppath))
+            return pos_invalid;
+    }
+    else
+    {
+        /* find the first step that has changed and the
+           first unchanged step after it */
+        int broken = -1, rejoin = -1;
+
+        for (int idx = steps->len - 1; idx >= 0; idx--)
+        {
+            map_route_step *step = &g_array_index(steps, map_route_step, idx);
+            gboolean intact = map_route_step_intact(m, step, route->element,
+                                                    ppath);
+
+            /* monsters only matter when they are in the way now */
+            if (intact && idx == (int)steps->len - 1)
+            {
+                monster *mon = map_get_monster_at(m, step->pos);
+                intact = (mon == NULL || (ppath && !monster_in_sight(mon)));
+            }
+
+            if (!intact && broken < 0)
+            {
+                broken = idx;
+            }
+            else if (intact && broken >= 0)
+            {
+                rejoin = idx;
+                break;
+            }
+        }
+
+        if (broken >= 0)
+        {
+            /* repair the route up to the step where it can be rejoined
+               or plan it again if there is no such step */
+            if (rejoin < 0
+                    || !map_route_plan(route, m, pos,
+                                       g_array_index(steps, map_route_step,
+                                                     rejoin).pos,
+                                       rejoin, ppath))
+            {
+                if (!map_route_plan(route, m, pos, route->goal, 0, ppath))
+                    return pos_invalid;
+            }
+        }
     }
 
-    g_ptr_array_free(path->open, TRUE);
+    route->last = pos;
 
-    for (guint idx = 0; idx < path->closed->len; idx++)
+    /* the end of the route on this map has been reached */
+    if (steps->len == 0)
+        return pos;
+
+    route->last = g_array_index(steps, map_route_step, steps->len - 1).pos;
+    g_array_set_size(steps, steps->len - 1);
+
+    return route->last;
+}
+
+void map_route_destroy(map_route *route)
+{
+    g_assert(route != NULL);
+
+    g_array_free(route->steps, TRUE);
+    g_free(route);
+}
+
+gboolean map_pos_passable_by(map *m, position pos, map_element_t element)
+{
+    g_assert(m != NULL && pos_valid(pos));
+
+    switch (map_tiletype_at(m, pos))
     {
-        g_free(g_ptr_array_index(path->closed, idx));
+    case LT_WALL:
+        return (element == LE_XORN);
+
+    case LT_DEEPWATER:
+        if (element == LE_SWIMMING_MONSTER)
+            return TRUE;
+        // else fall through
+    case LT_LAVA:
+        return (element == LE_FLYING_MONSTER);
+
+    default:
+        return map_pos_passable(m, pos);
     }
+}
+
+position map_step_to_player(map *m, position pos, map_element_t element)
+{
+    g_assert(m != NULL && pos_valid(pos) && element < LE_MAX);
+
+    map_dmap *dm = map_dmap_to_player(m, element);
+
+    if (dm == NULL)
+        return pos_invalid;
+
+    return map_dmap_step(m, dm, pos, element, NULL);
+}
+
+position map_step_from_player(map *m, position pos, map_element_t element)
+{
+    g_assert(m != NULL && pos_valid(pos) && element < LE_MAX);
+
+    map_dmap *dm = map_dmap_from_player(m, element);
+    gboolean lowest;
 
-    g_ptr_array_free(path->closed, TRUE);
+    if (dm == NULL)
+        return pos_invalid;
 
-    g_queue_free(path->path);
+    position npos = map_dmap_step(m, dm, pos, element, &lowest);
 
-    g_free(path);
+    /* staying is the best choice when there is no safer place around;
+       moving on would only lead back here */
+    return lowest ? pos : npos;
 }
 
 GList *map_ray(map *m, position source, position target)
@@ -963,6 +1483,8 @@ void map_set_tiletype(map *m, area *ar, map_tile_t type, guint8 duration)
                     tile->base_type = map_tiletype_at(m, pos);
 
                 tile->type = type;
+                map_tile_changed(m, pos);
+
                 /* if non-permanent, let the radius shrink with time */
                 if (duration != 0)
                     tile->timer = max(1, duration - 5 * pos_distance(pos, center));
@@ -971,6 +1493,21 @@ void map_set_tiletype(map *m, area *ar, map_tile_t type, guint8 duration)
     }
 }
 
+void map_tile_changed(map *m, position pos)
+{
+    g_assert(m != NULL && pos_valid(pos));
+
+    map_tile *tile = &m->grid[Y(pos)][X(pos)];
+    const guint64 bit = G_GUINT64_CONSTANT(1) << (X(pos) & 63);
+
+    if (mt_is_transparent(tile->type) && so_is_transparent(tile->sobject))
+        m->transparent[Y(pos)][X(pos) >> 6] |= bit;
+    else
+        m->transparent[Y(pos)][X(pos) >> 6] &= ~bit;
+
+    m->revision++;
+}
+
 damage *map_tile_damage(map *m, position pos, gboolean flying)
 {
     g_assert (m != NULL && pos_valid(pos));
@@ -1158,21 +1695,68 @@ gboolean map_is_exit_at(map *m, position pos)
     }
 }
 
-void map_timer(map *m)
+position map_exit_target(map *m, position pos)
 {
-    position pos = pos_invalid;
-    item_erosion_type erosion;
-
-    g_assert (m != NULL);
+    g_assert (m != NULL && pos_valid(pos));
 
-    Z(pos) = m->nlevel;
+    guint nlevel;
+    sobject_t target;
 
-    for (Y(pos) = 0; Y(pos) < MAP_MAX_Y; Y(pos)++)
+    switch (map_sobject_at(m, pos))
     {
-        for (X(pos) = 0; X(pos) < MAP_MAX_X; X(pos)++)
-        {
-            if (map_timer_at(m, pos))
-            {
+    case LS_DNGN_ENTRANCE:
+        nlevel = 1;
+        target = LS_DNGN_EXIT;
+        break;
+
+    case LS_DNGN_EXIT:
+        nlevel = 0;
+        target = LS_DNGN_ENTRANCE;
+        break;
+
+    case LS_STAIRSDOWN:
+        nlevel = m->nlevel + 1;
+        target = LS_STAIRSUP;
+        break;
+
+    case LS_STAIRSUP:
+        nlevel = m->nlevel - 1;
+        target = LS_STAIRSDOWN;
+        break;
+
+    case LS_ELEVATORDOWN:
+        /* the volcano shaft leads from the town to the temple */
+        nlevel = MAP_DMAX;
+        target = LS_ELEVATORUP;
+        break;
+
+    case LS_ELEVATORUP:
+        nlevel = 0;
+        target = LS_ELEVATORDOWN;
+        break;
+
+    default:
+        return pos_invalid;
+    }
+
+    return map_find_sobject(game_map(nlarn, nlevel), target);
+}
+
+void map_timer(map *m)
+{
+    position pos = pos_invalid;
+    item_erosion_type erosion;
+
+    g_assert (m != NULL);
+
+    Z(pos) = m->nlevel;
+
+    for (Y(pos) = 0; Y(pos) < MAP_MAX_Y; Y(pos)++)
+    {
+        for (X(pos) = 0; X(pos) < MAP_MAX_X; X(pos)++)
+        {
+            if (map_timer_at(m, pos))
+            {
                 map_tile *tile = map_tile_at(m, pos);
                 tile->timer--;
 
@@ -1214,6 +1798,8 @@ void map_timer(map *m)
                     {
                         tile->type = tile->base_type;
                     }
+
+                    map_tile_changed(m, pos);
                 }
             } /* if map_timer_at */
         } /* for X(pos) */
@@ -2174,6 +2760,23 @@ static int map_validate(map *m)
     return connected;
 }
 
+static void map_transparency_update(map *m)
+{
+    memset(m->transparent, 0, sizeof(m->transparent));
+
+    for (int y = 0; y < MAP_MAX_Y; y++)
+    {
+        for (int x = 0; x < MAP_MAX_X; x++)
+        {
+            if (mt_is_transparent(m->grid[y][x].type)
+                    && so_is_transparent(m->grid[y][x].sobject))
+            {
+                m->transparent[y][x >> 6] |= G_GUINT64_CONSTANT(1) << (x & 63);
+            }
+        }
+    }
+}
+
 /* subroutine to put an item onto an empty space */
 void map_item_add(map *m, item *what)
 {
@@ -2183,13 +2786,27 @@ void map_item_add(map *m, item *what)
 
 static map_path *map_path_new(position start, position goal)
 {
-    map_path *path;
+    map_path_storage *storage = &path_storage;
 
-    path = g_malloc0(sizeof(map_path));
+    /* use the shared storage unless it is in use by another path */
+    if (!g_atomic_int_compare_and_exchange(&path_storage_used, FALSE, TRUE))
+        storage = g_malloc0(sizeof(map_path_storage));
 
-    path->open   = g_ptr_array_new();
-    path->closed = g_ptr_array_new();
-    path->path   = g_queue_new();
+    map_path *path = &storage->path;
+
+    path->nodes = storage->nodes;
+    path->open  = storage->open;
+    path->open_len = 0;
+    path->path  = &storage->steps;
+    g_queue_init(path->path);
+
+    /* elements of earlier searches are recognised by their search number;
+       they have to be cleared once the number wraps around */
+    if (++path->search == 0)
+    {
+        memset(storage->nodes, 0, sizeof(storage->nodes));
+        path->search = 1;
+    }
 
     path->start = start;
     path->goal  = goal;
@@ -2197,14 +2814,68 @@ static map_path *map_path_new(position start, position goal)
     return path;
 }
 
-static map_path_element *map_path_element_new(position pos)
+/* prepend a step to the path */
+static void map_path_add_step(map_path *path, map_path_element *el)
+{
+    map_path_storage *storage = (map_path_storage *)path;
+    GList *link = &storage->links[path->path->length];
+
+    link->data = el;
+    g_queue_push_head_link(path->path, link);
+}
+
+/* get the search state of a position, initialising it when first seen */
+static map_path_element *map_path_element_at(map_path *path, position pos)
+{
+    map_path_element *el = &path->nodes[Y(pos) * MAP_MAX_X + X(pos)];
+
+    if (el->search != path->search)
+    {
+        /* left over from an earlier search */
+        el->search = path->search;
+        el->state = MAP_PATH_NEW;
+        el->parent = NULL;
+        el->pos = pos;
+
+        /* estimate the distance from the position to the target:
+           every step can move diagonally */
+        el->h_score = max(abs(X(pos) - X(path->goal)),
+                          abs(Y(pos) - Y(path->goal)));
+    }
+
+    return el;
+}
+
+/* additional cost of entering tiles covered with water, fire or cloud */
+static int map_tile_penalty(map_tile_t tt, map_element_t map_elem)
+{
+    switch (tt)
+    {
+    case LT_WATER:
+        if (map_elem == LE_SWIMMING_MONSTER || map_elem == LE_FLYING_MONSTER)
+            return 0;
+        /* else fall through */
+    case LT_FIRE:
+    case LT_CLOUD:
+        return 50;
+    default:
+        return 0;
+    }
+}
+
+/* the penalty for traps known to the player */
+static int map_trap_penalty(map *m, position pos)
 {
-    map_path_element *lpe;
+    if (!player_memory_of(nlarn->p, pos).trap)
+        return 0;
+
+    const trap_t trap = map_trap_at(m, pos);
 
-    lpe = g_malloc0(sizeof(map_path_element));
-    lpe->pos = pos;
+    /* especially ones that may cause detours */
+    if (trap == TT_TELEPORT || trap == TT_TRAPDOOR)
+        return 50;
 
-    return lpe;
+    return 10;
 }
 
 /* calculate the cost of stepping into this new field */
@@ -2228,15 +2899,8 @@ static int map_step_cost(map *m, map_path_element* element,
     }
 
     /* penalize for traps known to the player */
-    if (ppath && player_memory_of(nlarn->p, element->pos).trap)
-    {
-        const trap_t trap = map_trap_at(m, element->pos);
-        /* especially ones that may cause detours */
-        if (trap == TT_TELEPORT || trap == TT_TRAPDOOR)
-            step_cost += 50;
-        else
-            step_cost += 10;
-    }
+    if (ppath)
+        step_cost += map_trap_penalty(m, element->pos);
 
     /* penalize fields occupied by monsters: always for monsters,
        for the player only if (s)he can see the monster */
@@ -2246,72 +2910,110 @@ static int map_step_cost(map *m, map_path_element* element,
     }
 
     /* penalize fields covered with water, fire or cloud */
-    switch (tt)
-    {
-    case LT_WATER:
-        if (map_elem == LE_SWIMMING_MONSTER || map_elem == LE_FLYING_MONSTER)
-            break;
-        /* else fall through */
-    case LT_FIRE:
-    case LT_CLOUD:
-        step_cost += 50;
-        break;
-    default:
-        break;
-    }
+    step_cost += map_tile_penalty(tt, map_elem);
 
     return step_cost;
 }
 
-/* Returns the total estimated cost of the best path going
-   through this new field */
-static int map_path_cost(map_path_element* element, position target)
+/* Returns TRUE if the best path going through the first element
+   is estimated to be cheaper than the one through the second element */
+static inline gboolean map_path_cheaper(map_path_element *a,
+                                        map_path_element *b)
 {
-    /* estimate the distance from the current position to the target */
-    element->h_score = pos_distance(element->pos, target);
+    const guint32 fa = a->g_score + a->h_score;
+    const guint32 fb = b->g_score + b->h_score;
 
-    return element->g_score + element->h_score;
+    /* prefer elements closer to the target on ties */
+    return (fa < fb) || (fa == fb && a->h_score < b->h_score);
 }
 
-static map_path_element *map_path_element_in_list(map_path_element* el,
-                                                  GPtrArray *list)
+static inline void map_path_open_set(map_path *path, guint idx,
+                                     map_path_element *el)
 {
-    g_assert(el != NULL && list != NULL);
+    path->open[idx] = el;
+    el->open_idx = idx;
+}
+
+/* move an element towards the top of the heap until it is in order */
+static void map_path_open_sift_up(map_path *path, guint idx)
+{
+    map_path_element *el = path->open[idx];
 
-    for (guint idx = 0; idx < list->len; idx++)
+    while (idx > 0)
     {
-        map_path_element *li = g_ptr_array_index(list, idx);
+        guint parent = (idx - 1) / 2;
+
+        if (!map_path_cheaper(el, path->open[parent]))
+            break;
 
-        if (pos_identical(li->pos, el->pos))
-            return li;
+        map_path_open_set(path, idx, path->open[parent]);
+        idx = parent;
     }
 
-    return NULL;
+    map_path_open_set(path, idx, el);
 }
 
-static map_path_element *map_path_find_best(map_path *path)
+/* move an element towards the bottom of the heap until it is in order */
+static void map_path_open_sift_down(map_path *path, guint idx)
 {
-    map_path_element *el, *best = NULL;
+    map_path_element *el = path->open[idx];
 
-    for (guint idx = 0; idx < path->open->len; idx++)
+    while (2 * idx + 1 < path->open_len)
     {
-        el = g_ptr_array_index(path->open, idx);
+        guint child = 2 * idx + 1;
 
-        if (best == NULL || map_path_cost(el, path->goal)
-                < map_path_cost(best, path->goal))
-        {
-            best = el;
-        }
+        if (child + 1 < path->open_len
+                && map_path_cheaper(path->open[child + 1], path->open[child]))
+            child++;
+
+        if (!map_path_cheaper(path->open[child], el))
+            break;
+
+        map_path_open_set(path, idx, path->open[child]);
+        idx = child;
+    }
+
+    map_path_open_set(path, idx, el);
+}
+
+static void map_path_open_push(map_path *path, map_path_element *el)
+{
+    g_assert(path->open_len < MAP_SIZE);
+
+    el->state = MAP_PATH_OPEN;
+    path->open[path->open_len] = el;
+    map_path_open_sift_up(path, path->open_len++);
+}
+
+/* remove the most promising element from the open list */
+static map_path_element *map_path_open_pop(map_path *path)
+{
+    map_path_element *best = path->open[0];
+
+    if (--path->open_len > 0)
+    {
+        path->open[0] = path->open[path->open_len];
+        map_path_open_sift_down(path, 0);
     }
 
     return best;
 }
 
-static GPtrArray *map_path_get_neighbours(map *m, position pos,
-                                          map_element_t element,
-                                          gboolean ppath)
+/* restore the heap order after the score of an open element decreased */
+static void map_path_open_update(map_path *path, map_path_element *el)
+{
+    g_assert(el->state == MAP_PATH_OPEN);
+
+    map_path_open_sift_up(path, el->open_idx);
+}
+
+/* collect the positions adjacent to pos that can be entered;
+   returns the number of positions stored in neighbours */
+static int map_path_get_neighbours(map *m, position pos,
+                                   map_element_t element,
+                                   gboolean ppath, position *neighbours)
 {
-    GPtrArray *neighbours = g_ptr_array_new();
+    int count = 0;
 
     for (direction dir = GD_NONE + 1; dir < GD_MAX; dir++)
     {
@@ -2326,10 +3028,1437 @@ static GPtrArray *map_path_get_neighbours(map *m, position pos,
         if ((ppath && mt_is_passable(player_memory_of(nlarn->p, npos).type))
                 || (!ppath && monster_valid_dest(m, npos, element)))
         {
-            map_path_element *pe = map_path_element_new(npos);
-            g_ptr_array_add(neighbours, pe);
+            neighbours[count++] = npos;
+        }
+    }
+
+    return count;
+}
+
+/* entry of the queue used when scanning distance maps */
+typedef struct map_dmap_entry
+{
+    gint32 dist;
+    guint32 idx;
+} map_dmap_entry;
+
+/* Every position is queued at most once per neighbour and once initially */
+#define MAP_DMAP_QUEUE_LEN ((GD_MAX + 1) * MAP_SIZE)
+
+/* the queue is only used while scanning, thus it can be shared */
+static map_dmap_entry dmap_queue[MAP_DMAP_QUEUE_LEN];
+
+static void map_dmap_queue_push(map_dmap_entry *queue, guint *len,
+                                gint32 dist, guint32 idx)
+{
+    guint pos = (*len)++;
+
+    while (pos > 0 && queue[(pos - 1) / 2].dist > dist)
+    {
+        queue[pos] = queue[(pos - 1) / 2];
+        pos = (pos - 1) / 2;
+    }
+
+    queue[pos].dist = dist;
+    queue[pos].idx = idx;
+}
+
+static map_dmap_entry map_dmap_queue_pop(map_dmap_entry *queue, guint *len)
+{
+    map_dmap_entry top = queue[0];
+    map_dmap_entry last = queue[--(*len)];
+    guint pos = 0;
+
+    while (2 * pos + 1 < *len)
+    {
+        guint child = 2 * pos + 1;
+
+        if (child + 1 < *len && queue[child + 1].dist < queue[child].dist)
+            child++;
+
+        if (queue[child].dist >= last.dist)
+            break;
+
+        queue[pos] = queue[child];
+        pos = child;
+    }
+
+    queue[pos] = last;
+
+    return top;
+}
+
+/*
+ * Propagate the distances of a distance map: every position that can be
+ * entered by the map element gets the lowest sum of the distance of a
+ * neighbour and the cost of stepping onto that neighbour. Positions with
+ * a distance other than MAP_DMAP_UNREACHABLE are the starting points.
+ * For the player, the map is scanned as (s)he remembers it.
+ */
+static void map_dmap_scan(map *m, map_dmap *dm, map_element_t element,
+                          gboolean ppath)
+{
+    gboolean passable[MAP_MAX_Y][MAP_MAX_X];
+    gint32 penalty[MAP_MAX_Y][MAP_MAX_X];
+    position pos = pos_invalid;
+    guint len = 0;
+
+    Z(pos) = m->nlevel;
+    for (Y(pos) = 0; Y(pos) < MAP_MAX_Y; Y(pos)++)
+    {
+        for (X(pos) = 0; X(pos) < MAP_MAX_X; X(pos)++)
+        {
+            if (ppath)
+            {
+                const map_tile_t tt = player_memory_of(nlarn->p, pos).type;
+
+                passable[Y(pos)][X(pos)] = mt_is_passable(tt);
+                penalty[Y(pos)][X(pos)] = map_tile_penalty(tt, element)
+                                          + map_trap_penalty(m, pos);
+            }
+            else
+            {
+                passable[Y(pos)][X(pos)] = map_pos_passable_by(m, pos, element);
+                penalty[Y(pos)][X(pos)] = map_tile_penalty(map_tiletype_at(m, pos), element);
+            }
+
+            if (map_dmap_at(dm, pos) != MAP_DMAP_UNREACHABLE)
+                map_dmap_queue_push(dmap_queue, &len, map_dmap_at(dm, pos),
+                                    Y(pos) * MAP_MAX_X + X(pos));
+        }
+    }
+
+    while (len > 0)
+    {
+        map_dmap_entry curr = map_dmap_queue_pop(dmap_queue, &len);
+        const int x = curr.idx % MAP_MAX_X, y = curr.idx / MAP_MAX_X;
+
+        /* outdated entry of a position that has been reached cheaper */
+        if (curr.dist > dm->dist[y][x])
+            continue;
+
+        /* cost of stepping onto the current position */
+        const gint32 dist = curr.dist + 1 + penalty[y][x];
+
+        for (int ny = max(y - 1, 0); ny <= min(y + 1, MAP_MAX_Y - 1); ny++)
+        {
+            for (int nx = max(x - 1, 0); nx <= min(x + 1, MAP_MAX_X - 1); nx++)
+            {
+                if (!passable[ny][nx] || dist >= dm->dist[ny][nx])
+                    continue;
+
+                dm->dist[ny][nx] = dist;
+                map_dmap_queue_push(dmap_queue, &len, dist, ny * MAP_MAX_X + nx);
+            }
+        }
+    }
+}
+
+/* fill a distance map with the costs of the ways to a position */
+static void map_dmap_towards(map *m, map_dmap *dm, position goal,
+                             map_element_t element, gboolean ppath)
+{
+    for (int y = 0; y < MAP_MAX_Y; y++)
+        for (int x = 0; x < MAP_MAX_X; x++)
+            dm->dist[y][x] = MAP_DMAP_UNREACHABLE;
+
+    dm->dist[Y(goal)][X(goal)] = 0;
+    map_dmap_scan(m, dm, element, ppath);
+
+    dm->goal = goal;
+    dm->revision = m->revision;
+    dm->valid = TRUE;
+}
+
+/*
+ * Find the free neighbour of a position that leads downhill on a distance
+ * map at the lowest cost. If lowest is not NULL, it is set to TRUE if no
+ * neighbour has a lower distance at all.
+ */
+static position map_dmap_step(map *m, map_dmap *dm, position pos,
+                              map_element_t element, gboolean *lowest)
+{
+    position best = pos_invalid;
+    gint32 best_cost = G_MAXINT32;
+    const gint32 dist = map_dmap_at(dm, pos);
+
+    if (lowest != NULL)
+        *lowest = TRUE;
+
+    for (direction dir = GD_NONE + 1; dir < GD_MAX; dir++)
+    {
+        if (dir == GD_CURR)
+            continue;
+
+        position npos = pos_move(pos, dir);
+
+        /* the position has to be lower than the current one */
+        if (!pos_valid(npos) || map_dmap_at(dm, npos) >= dist)
+            continue;
+
+        if (lowest != NULL)
+            *lowest = FALSE;
+
+        /* the cost of the remaining way when stepping onto npos */
+        gint32 cost = map_dmap_at(dm, npos)
+                      + 1 + map_tile_penalty(map_tiletype_at(m, npos), element);
+
+        if (cost < best_cost && monster_valid_dest(m, npos, element))
+        {
+            best_cost = cost;
+            best = npos;
+        }
+    }
+
+    return best;
+}
+
+/* get the distances to the player, updating them if necessary */
+static map_dmap *map_dmap_to_player(map *m, map_element_t element)
+{
+    const position goal = nlarn->p->pos;
+
+    if (Z(goal) != m->nlevel)
+        return NULL;
+
+    if (m->dmaps[element] == NULL)
+        m->dmaps[element] = g_malloc0(sizeof(map_dmap));
+
+    map_dmap *dm = m->dmaps[element];
+
+    if (dm->valid && dm->revision == m->revision
+            && pos_identical(dm->goal, goal))
+    {
+        /* still up to date */
+        return dm;
+    }
+
+    map_dmap_towards(m, dm, goal, element, FALSE);
+
+    return dm;
+}
+
+/* get the safety map for fleeing, updating it if necessary */
+static map_dmap *map_dmap_from_player(map *m, map_element_t element)
+{
+    map_dmap *to = map_dmap_to_player(m, element);
+
+    if (to == NULL)
+        return NULL;
+
+    if (m->safety[element] == NULL)
+        m->safety[element] = g_malloc0(sizeof(map_dmap));
+
+    map_dmap *dm = m->safety[element];
+
+    if (dm->valid && dm->revision == to->revision
+            && pos_identical(dm->goal, to->goal))
+    {
+        /* still up to date */
+        return dm;
+    }
+
+    /* Invert the distances to the player, scaled by 1.2. Spreading the
+       result again lowers positions that lead to the most remote ones;
+       the factor decides how close a monster may get to the player
+       on its way there instead of running into a dead end. */
+    for (int y = 0; y < MAP_MAX_Y; y++)
+    {
+        for (int x = 0; x < MAP_MAX_X; x++)
+        {
+            if (to->dist[y][x] == MAP_DMAP_UNREACHABLE)
+                dm->dist[y][x] = MAP_DMAP_UNREACHABLE;
+            else
+                dm->dist[y][x] = -(to->dist[y][x] * 6 / 5);
         }
     }
 
-    return neighbours;
+    map_dmap_scan(m, dm, element, FALSE);
+
+    dm->goal = to->goal;
+    dm->revision = to->revision;
+    dm->valid = TRUE;
+
+    return dm;
+}
+
+/* the first step of the way from start to goal and the cost of the way */
+static position map_path_first_step(map *m, position start, position goal,
+                                    map_element_t element, gint32 *cost)
+{
+    *cost = 0;
+
+    if (pos_identical(start, goal))
+        return start;
+
+    map_path *path = map_find_path(m, start, goal, element);
+    position step = pos_invalid;
+
+    *cost = MAP_DMAP_UNREACHABLE;
+
+    if (path != NULL)
+    {
+        /* the path is empty if the start is the exit to take */
+        if (g_queue_is_empty(path->path))
+        {
+            step = start;
+            *cost = 0;
+        }
+        else
+        {
+            step = ((map_path_element *)g_queue_peek_head(path->path))->pos;
+            *cost = ((map_path_element *)g_queue_peek_tail(path->path))->g_score;
+        }
+
+        map_path_destroy(path);
+    }
+
+    return step;
+}
+
+/* order path queries by map element, goal and start */
+static int map_path_query_cmp(const void *a, const void *b)
+{
+    const map_path_query *qa = *(map_path_query **)a;
+    const map_path_query *qb = *(map_path_query **)b;
+
+    if (qa->element != qb->element)
+        return (qa->element < qb->element) ? -1 : 1;
+
+    if (qa->goal.val != qb->goal.val)
+        return (qa->goal.val < qb->goal.val) ? -1 : 1;
+
+    if (qa->start.val != qb->start.val)
+        return (qa->start.val < qb->start.val) ? -1 : 1;
+
+    /* keep the order of identical queries */
+    return (qa < qb) ? -1 : (qa > qb);
+}
+
+static gboolean map_path_query_same_goal(map_path_query *a, map_path_query *b)
+{
+    return (a->element == b->element) && pos_identical(a->goal, b->goal);
+}
+
+/* memory for searching the ways of all queries leading to a goal */
+typedef struct map_paths_search
+{
+    gint32 dist[MAP_MAX_Y][MAP_MAX_X];   /* the cost of the way to the goal */
+    gboolean start[MAP_MAX_Y][MAP_MAX_X]; /* starts not yet reached */
+    map_dmap_entry queue[MAP_DMAP_QUEUE_LEN];
+} map_paths_search;
+
+/*
+ * Find the first steps of all queries with a common goal. The search
+ * spreads from the goal like the one of a distance map, but with the
+ * costs used by map_find_path(), until all starts have been reached.
+ */
+static void map_paths_search_goal(map *m, map_paths_search *s,
+                                  map_path_query **queries, guint count)
+{
+    const position goal = queries[0]->goal;
+    const map_element_t element = queries[0]->element;
+    position pos = pos_invalid;
+    guint pending = 0, len = 0;
+
+    for (int y = 0; y < MAP_MAX_Y; y++)
+        for (int x = 0; x < MAP_MAX_X; x++)
+            s->dist[y][x] = MAP_DMAP_UNREACHABLE;
+
+    memset(s->start, 0, sizeof(s->start));
+
+    for (guint idx = 0; idx < count; idx++)
+    {
+        map_path_query *q = queries[idx];
+
+        q->step = pos_identical(q->start, goal) ? q->start : pos_invalid;
+        q->cost = pos_identical(q->start, goal) ? 0 : MAP_DMAP_UNREACHABLE;
+
+        if (pos_identical(q->start, goal)
+                || !map_pos_connected(m, q->start, goal, element)
+                || s->start[Y(q->start)][X(q->start)])
+            continue;
+
+        s->start[Y(q->start)][X(q->start)] = TRUE;
+        pending++;
+    }
+
+    /* monsters can only walk to free positions */
+    if (pending == 0 || !monster_valid_dest(m, goal, element))
+        return;
+
+    s->dist[Y(goal)][X(goal)] = 0;
+    map_dmap_queue_push(s->queue, &len, 0, Y(goal) * MAP_MAX_X + X(goal));
+
+    Z(pos) = m->nlevel;
+    while (len > 0 && pending > 0)
+    {
+        map_dmap_entry curr = map_dmap_queue_pop(s->queue, &len);
+
+        X(pos) = curr.idx % MAP_MAX_X;
+        Y(pos) = curr.idx / MAP_MAX_X;
+
+        /* outdated entry of a position that has been reached cheaper */
+        if (curr.dist > s->dist[Y(pos)][X(pos)])
+            continue;
+
+        if (s->start[Y(pos)][X(pos)])
+        {
+            s->start[Y(pos)][X(pos)] = FALSE;
+            pending--;
+
+            /* the position of the monster itself cannot be passed */
+            if (!monster_valid_dest(m, pos, element))
+                continue;
+        }
+
+        /* cost of stepping onto the current position */
+        map_path_element el = { .pos = pos };
+        const gint32 dist = curr.dist + map_step_cost(m, &el, element, FALSE);
+
+        for (direction dir = GD_NONE + 1; dir < GD_MAX; dir++)
+        {
+            if (dir == GD_CURR)
+                continue;
+
+            position npos = pos_move(pos, dir);
+
+            if (!pos_valid(npos) || dist >= s->dist[Y(npos)][X(npos)])
+                continue;
+
+            if (!s->start[Y(npos)][X(npos)]
+                    && !monster_valid_dest(m, npos, element))
+                continue;
+
+            s->dist[Y(npos)][X(npos)] = dist;
+            map_dmap_queue_push(s->queue, &len, dist,
+                                Y(npos) * MAP_MAX_X + X(npos));
+        }
+    }
+
+    for (guint idx = 0; idx < count; idx++)
+    {
+        map_path_query *q = queries[idx];
+        gint32 best_cost = MAP_DMAP_UNREACHABLE;
+
+        if (pos_valid(q->step)
+                || s->dist[Y(q->start)][X(q->start)] == MAP_DMAP_UNREACHABLE)
+            continue;
+
+        /* the neighbour with the cheapest remaining way */
+        for (direction dir = GD_NONE + 1; dir < GD_MAX; dir++)
+        {
+            if (dir == GD_CURR)
+                continue;
+
+            position npos = pos_move(q->start, dir);
+
+            if (!pos_valid(npos)
+                    || s->dist[Y(npos)][X(npos)] == MAP_DMAP_UNREACHABLE
+                    || !monster_valid_dest(m, npos, element))
+                continue;
+
+            map_path_element el = { .pos = npos };
+            gint32 cost = s->dist[Y(npos)][X(npos)]
+                          + map_step_cost(m, &el, element, FALSE);
+
+            if (cost < best_cost)
+            {
+                best_cost = cost;
+                q->step = npos;
+                q->cost = cost;
+            }
+        }
+    }
+}
+
+/* solve the path queries of a slice of a batch */
+static gpointer map_paths_solve(gpointer data)
+{
+    map_paths_slice *slice = (map_paths_slice *)data;
+    map_path_query **queries = slice->queries;
+    map_paths_search *search = NULL;
+    guint last;
+
+    for (guint first = 0; first < slice->count; first = last)
+    {
+        /* find all queries with the same goal */
+        for (last = first + 1; last < slice->count; last++)
+            if (!map_path_query_same_goal(queries[first], queries[last]))
+                break;
+
+        if (pos_identical(queries[first]->start, queries[last - 1]->start))
+        {
+            /* a single start: searching from there is faster */
+            gint32 cost;
+            position step = map_path_first_step(slice->m, queries[first]->start,
+                                                queries[first]->goal,
+                                                queries[first]->element, &cost);
+
+            for (guint idx = first; idx < last; idx++)
+            {
+                queries[idx]->step = step;
+                queries[idx]->cost = cost;
+            }
+
+            continue;
+        }
+
+        if (search == NULL)
+            search = g_malloc(sizeof(map_paths_search));
+
+        map_paths_search_goal(slice->m, search, queries + first, last - first);
+    }
+
+    g_free(search);
+
+    return NULL;
+}
+
+/*
+ * The exits of a map and the costs of walking between them. These are
+ * the edges of the graph used to plan ways across maps. Like distance
+ * maps, the costs do not take monsters into account.
+ */
+#define MAP_EXIT_MAX 3
+
+typedef struct map_exits
+{
+    int count;
+    position pos[MAP_EXIT_MAX];
+    gint32 cost[MAP_EXIT_MAX][MAP_EXIT_MAX]; /* from one exit to another */
+    guint32 revision;
+    gboolean valid;
+} map_exits;
+
+/* the cost of the cheapest way between two positions of a map */
+static gint32 map_path_cost(map *m, position start, position goal,
+                            map_element_t element)
+{
+    map_path *path = map_find_path(m, start, goal, element);
+    gint32 cost = MAP_DMAP_UNREACHABLE;
+
+    if (path == NULL)
+        return cost;
+
+    if (g_queue_is_empty(path->path))
+        cost = 0;
+    else
+        cost = ((map_path_element *)g_queue_peek_tail(path->path))->g_score;
+
+    map_path_destroy(path);
+
+    return cost;
+}
+
+/* find the exits of a map and the costs between them; for the player
+   only the exits and the parts of the map (s)he remembers count */
+static void map_exits_scan(map *m, map_exits *mx, map_element_t element,
+                           gboolean ppath)
+{
+    map_dmap dm;
+    position pos = pos_invalid;
+
+    mx->count = 0;
+    Z(pos) = m->nlevel;
+
+    for (Y(pos) = 0; Y(pos) < MAP_MAX_Y; Y(pos)++)
+    {
+        for (X(pos) = 0; X(pos) < MAP_MAX_X; X(pos)++)
+        {
+            if (!map_is_exit_at(m, pos) || mx->count == MAP_EXIT_MAX)
+                continue;
+
+            if (ppath && player_memory_of(nlarn->p, pos).sobject
+                    != map_sobject_at(m, pos))
+                continue;
+
+            mx->pos[mx->count++] = pos;
+        }
+    }
+
+    for (int to = 0; to < mx->count; to++)
+    {
+        map_dmap_towards(m, &dm, mx->pos[to], element, ppath);
+
+        for (int from = 0; from < mx->count; from++)
+            mx->cost[from][to] = map_dmap_at(&dm, mx->pos[from]);
+    }
+
+    mx->revision = m->revision;
+    mx->valid = TRUE;
+}
+
+/* get the exits of a map, updating the costs if necessary */
+static map_exits *map_exits_get(map *m, map_element_t element)
+{
+    if (m->exits[element] == NULL)
+        m->exits[element] = g_malloc0(sizeof(map_exits));
+
+    map_exits *mx = m->exits[element];
+
+    if (!mx->valid || mx->revision != m->revision)
+        map_exits_scan(m, mx, element, FALSE);
+
+    return mx;
+}
+
+/*
+ * Plan a way to a position on another map with Dijkstra's algorithm on the
+ * graph of the map exits. Only the ways from the start to the exits of the
+ * starting map and from the exits of the goal's map to the goal have to
+ * be searched; the costs between the exits of a map are cached. The
+ * player's memory of the maps changes without the maps changing, thus
+ * the costs for the player are determined anew.
+ */
+static map_path *map_find_path_across(map *m, position start, position goal,
+                                      map_element_t element)
+{
+    position node[MAP_MAX * MAP_EXIT_MAX];
+    gint32 dist[MAP_MAX * MAP_EXIT_MAX];
+    int first[MAP_MAX * MAP_EXIT_MAX];     /* exit taken on the starting map */
+    gboolean done[MAP_MAX * MAP_EXIT_MAX] = { FALSE };
+    int base[MAP_MAX + 1];                 /* first node of each map */
+    map_exits *exits[MAP_MAX] = { NULL };
+    map_exits *known = NULL;               /* the exits the player knows */
+    map_dmap *to_goal = g_malloc(sizeof(map_dmap));
+
+    gint32 best = MAP_DMAP_UNREACHABLE;
+    int best_first = -1;
+
+    /* the player does not know the way through unvisited maps */
+    gboolean ppath = pos_identical(start, nlarn->p->pos);
+
+    int count = 0;
+
+    for (guint nlevel = 0; nlevel < MAP_MAX; nlevel++)
+    {
+        map *nmap = game_map(nlarn, nlevel);
+        base[nlevel] = count;
+
+        if (ppath && nlevel != Z(start) && nmap->visited == 0)
+            continue;
+
+        if (ppath)
+        {
+            if (known == NULL)
+                known = g_malloc(MAP_MAX * sizeof(map_exits));
+
+            exits[nlevel] = &known[nlevel];
+            map_exits_scan(nmap, exits[nlevel], element, TRUE);
+        }
+        else
+        {
+            exits[nlevel] = map_exits_get(nmap, element);
+        }
+
+        map_exits *mx = exits[nlevel];
+
+        for (int idx = 0; idx < mx->count; idx++)
+        {
+            node[count] = mx->pos[idx];
+            dist[count] = MAP_DMAP_UNREACHABLE;
+            first[count] = -1;
+            count++;
+        }
+    }
+
+    base[MAP_MAX] = count;
+
+    /* the ways from the exits of the goal's map to the goal */
+    map_dmap_towards(game_map(nlarn, Z(goal)), to_goal, goal, element, ppath);
+
+    /* the ways to the exits of the starting map */
+    for (int idx = base[Z(start)]; idx < base[Z(start) + 1]; idx++)
+    {
+        dist[idx] = map_path_cost(m, start, node[idx], element);
+        first[idx] = idx;
+    }
+
+    while (TRUE)
+    {
+        int curr = -1;
+
+        for (int idx = 0; idx < count; idx++)
+        {
+            if (!done[idx] && dist[idx] != MAP_DMAP_UNREACHABLE
+                    && (curr < 0 || dist[idx] < dist[curr]))
+                curr = idx;
+        }
+
+        /* no way left that could be cheaper */
+        if (curr < 0 || dist[curr] >= best)
+            break;
+
+        done[curr] = TRUE;
+
+        const guint nlevel = Z(node[curr]);
+        map *nmap = game_map(nlarn, nlevel);
+
+        if (nlevel == Z(goal))
+        {
+            gint32 cost = map_dmap_at(to_goal, node[curr]);
+
+            if (cost != MAP_DMAP_UNREACHABLE && dist[curr] + cost < best)
+            {
+                best = dist[curr] + cost;
+                best_first = first[curr];
+            }
+        }
+
+        /* walk to another exit of the same map */
+        map_exits *mx = exits[nlevel];
+        const int from = curr - base[nlevel];
+
+        for (int to = 0; to < mx->count; to++)
+        {
+            const int next = base[nlevel] + to;
+
+            if (mx->cost[from][to] == MAP_DMAP_UNREACHABLE
+                    || dist[curr] + mx->cost[from][to] >= dist[next])
+                continue;
+
+            dist[next] = dist[curr] + mx->cost[from][to];
+            first[next] = first[curr];
+        }
+
+        /* take the exit, which takes a turn */
+        position target = map_exit_target(nmap, node[curr]);
+
+        if (!pos_valid(target))
+            continue;
+
+        for (int next = base[Z(target)]; next < base[Z(target) + 1]; next++)
+        {
+            if (pos_identical(node[next], target) && dist[curr] + 1 < dist[next])
+            {
+                dist[next] = dist[curr] + 1;
+                first[next] = first[curr];
+            }
+        }
+    }
+
+    g_free(known);
+    g_free(to_goal);
+
+    if (best_first < 0)
+        return NULL;
+
+    return map_find_path(m, start, node[best_first], element);
+}
+
+/* the state of a map tile as seen by the traveller */
+static map_route_step map_route_step_at(map *m, position pos, gboolean ppath)
+{
+    map_route_step step = { pos, map_tiletype_at(m, pos), TT_NONE };
+
+    if (ppath)
+    {
+        step.type = player_memory_of(nlarn->p, pos).type;
+        step.trap = player_memory_of(nlarn->p, pos).trap;
+    }
+
+    return step;
+}
+
+static gboolean map_route_step_intact(map *m, map_route_step *step,
+                                      map_element_t element, gboolean ppath)
+{
+    map_route_step now = map_route_step_at(m, step->pos, ppath);
+
+    if (now.type != step->type || now.trap != step->trap)
+        return FALSE;
+
+    /* doors may have been closed */
+    return ppath || map_pos_passable_by(m, step->pos, element);
+}
+
+/* replace the steps of a route beyond the given number of remaining steps
+   with the steps of a new path */
+static gboolean map_route_plan(map_route *route, map *m, position pos,
+                               position goal, guint keep, gboolean ppath)
+{
+    map_path *path = map_find_path(m, pos, goal, route->element);
+
+    if (path == NULL)
+        return FALSE;
+
+    g_array_set_size(route->steps, keep);
+
+    for (GList *iter = path->path->tail; iter != NULL; iter = iter->prev)
+    {
+        map_path_element *el = iter->data;
+        map_route_step step = map_route_step_at(m, el->pos, ppath);
+
+        g_array_append_val(route->steps, step);
+    }
+
+    map_path_destroy(path);
+
+    return TRUE;
+}
+
+/*
+ * Check if every position can be entered at the same cost. The positions
+ * the traveller can enter are recorded for jump point search.
+ */
+static gboolean map_path_uniform(map *m, map_path *path,
+                                 map_element_t element, gboolean ppath)
+{
+    map_path_storage *storage = (map_path_storage *)path;
+    position pos = pos_invalid;
+
+    memset(storage->free, 0, sizeof(storage->free));
+
+    Z(pos) = m->nlevel;
+    for (Y(pos) = 0; Y(pos) < MAP_MAX_Y; Y(pos)++)
+    {
+        for (X(pos) = 0; X(pos) < MAP_MAX_X; X(pos)++)
+        {
+            map_tile *tile = map_tile_at(m, pos);
+            gboolean *free = &storage->free[Y(pos) + 1][X(pos) + 1];
+
+            if (ppath)
+            {
+                player_tile_memory *mem = &player_memory_of(nlarn->p, pos);
+
+                if (mem->trap || map_tile_penalty(mem->type, element))
+                    return FALSE;
+
+                monster *mon = map_get_monster_at(m, pos);
+
+                if (mon != NULL && monster_in_sight(mon))
+                    return FALSE;
+
+                *free = mt_is_passable(mem->type);
+            }
+            else
+            {
+                if (map_tile_penalty(tile->type, element))
+                    return FALSE;
+
+                /* monsters block passable positions; they only add to
+                   the cost where other monsters pass through walls */
+                if (tile->m_oid != NULL && !map_pos_passable(m, pos))
+                    return FALSE;
+
+                *free = monster_valid_dest(m, pos, element);
+            }
+        }
+    }
+
+    return TRUE;
+}
+
+/*
+ * Move into one direction until reaching a position that has to be
+ * examined: the goal or a position with neighbours that cannot be
+ * reached as cheaply without passing it. Diagonal moves also stop where
+ * a straight move from the position would.
+ */
+#define FREE(fx, fy) (storage->free[(fy) + 1][(fx) + 1])
+
+static gboolean map_path_jump(map_path *path, int x, int y, int dx, int dy,
+                              position *jpos)
+{
+    map_path_storage *storage = (map_path_storage *)path;
+
+    while (TRUE)
+    {
+        x += dx;
+        y += dy;
+
+        if (!FREE(x, y))
+            return FALSE;
+
+        if (x == X(path->goal) && y == Y(path->goal))
+            break;
+
+        if (dx != 0 && dy != 0)
+        {
+            if ((!FREE(x - dx, y) && FREE(x - dx, y + dy))
+                    || (!FREE(x, y - dy) && FREE(x + dx, y - dy)))
+                break;
+
+            if (map_path_jump(path, x, y, dx, 0, jpos)
+                    || map_path_jump(path, x, y, 0, dy, jpos))
+                break;
+        }
+        else if (dx != 0)
+        {
+            if ((!FREE(x, y + 1) && FREE(x + dx, y + 1))
+                    || (!FREE(x, y - 1) && FREE(x + dx, y - 1)))
+                break;
+        }
+        else
+        {
+            if ((!FREE(x + 1, y) && FREE(x + 1, y + dy))
+                    || (!FREE(x - 1, y) && FREE(x - 1, y + dy)))
+                break;
+        }
+    }
+
+    *jpos = path->goal;
+    X(*jpos) = x;
+    Y(*jpos) = y;
+
+    return TRUE;
+}
+
+/* determine the directions to search from a position */
+static int map_path_jps_directions(map_path *path, map_path_element *el,
+                                   int dirs[GD_MAX][2])
+{
+    map_path_storage *storage = (map_path_storage *)path;
+    const int x = X(el->pos), y = Y(el->pos);
+    int count = 0;
+    if (el->parent == NULL)
+    {
+        /* all directions from the start */
+        for (int dy = -1; dy <= 1; dy++)
+            for (int dx = -1; dx <= 1; dx++)
+                if (dx != 0 || dy != 0)
+                {
+                    dirs[count][0] = dx;
+                    dirs[count++][1] = dy;
+                }
+
+        return count;
+    }
+
+    const int dx = (x > X(el->parent->pos)) - (x < X(el->parent->pos));
+    const int dy = (y > Y(el->parent->pos)) - (y < Y(el->parent->pos));
+
+#define DIR(ddx, ddy) { dirs[count][0] = (ddx); dirs[count++][1] = (ddy); }
+
+    if (dx != 0 && dy != 0)
+    {
+        DIR(dx, 0);
+        DIR(0, dy);
+        DIR(dx, dy);
+
+        if (!FREE(x - dx, y))
+            DIR(-dx, dy);
+
+        if (!FREE(x, y - dy))
+            DIR(dx, -dy);
+    }
+    else if (dx != 0)
+    {
+        DIR(dx, 0);
+
+        if (!FREE(x, y + 1))
+            DIR(dx, 1);
+
+        if (!FREE(x, y - 1))
+            DIR(dx, -1);
+    }
+    else
+    {
+        DIR(0, dy);
+
+        if (!FREE(x + 1, y))
+            DIR(1, dy);
+
+        if (!FREE(x - 1, y))
+            DIR(-1, dy);
+    }
+
+#undef DIR
+#undef FREE
+
+    return count;
+}
+
+/*
+ * Jump point search: the same search as in map_find_path(), but only the
+ * jump points are added to the open list. The positions between them are
+ * filled in when the path is reconstructed.
+ */
+static map_path *map_find_path_jps(map_path *path)
+{
+    map_path_element *curr = map_path_element_at(path, path->start);
+    int dirs[GD_MAX][2];
+
+    curr->g_score = 0;
+    map_path_open_push(path, curr);
+
+    while (path->open_len)
+    {
+        curr = map_path_open_pop(path);
+        curr->state = MAP_PATH_CLOSED;
+
+        if (pos_identical(curr->pos, path->goal))
+        {
+            /* reconstruct the path, including the positions that
+               have been jumped over */
+            while (curr->parent != NULL)
+            {
+                map_path_element *parent = curr->parent;
+                const guint32 g_score = curr->g_score;
+                const int dx = (X(parent->pos) > X(curr->pos))
+                               - (X(parent->pos) < X(curr->pos));
+                const int dy = (Y(parent->pos) > Y(curr->pos))
+                               - (Y(parent->pos) < Y(curr->pos));
+                position pos = curr->pos;
+
+                for (guint32 step = 0; !pos_identical(pos, parent->pos); step++)
+                {
+                    map_path_element *el = map_path_element_at(path, pos);
+                    el->g_score = g_score - step;
+                    map_path_add_step(path, el);
+
+                    X(pos) += dx;
+                    Y(pos) += dy;
+                }
+
+                curr = parent;
+            }
+
+            return path;
+        }
+
+        int count = map_path_jps_directions(path, curr, dirs);
+
+        for (int idx = 0; idx < count; idx++)
+        {
+            position jpos;
+
+            if (!map_path_jump(path, X(curr->pos), Y(curr->pos),
+                               dirs[idx][0], dirs[idx][1], &jpos))
+                continue;
+
+            map_path_element *next = map_path_element_at(path, jpos);
+
+            if (next->state == MAP_PATH_CLOSED)
+                continue;
+
+            const guint32 next_g_score = curr->g_score
+                + max(abs(X(jpos) - X(curr->pos)), abs(Y(jpos) - Y(curr->pos)));
+
+            if (next->state == MAP_PATH_NEW)
+            {
+                next->parent  = curr;
+                next->g_score = next_g_score;
+                map_path_open_push(path, next);
+            }
+            else if (next->g_score > next_g_score)
+            {
+                next->parent  = curr;
+                next->g_score = next_g_score;
+                map_path_open_update(path, next);
+            }
+        }
+    }
+
+    /* could not find a path */
+    map_path_destroy(path);
+
+    return NULL;
+}
+
+/*
+ * The connected areas of a map: positions that can be entered by a map
+ * element are labelled with the number of the area they belong to,
+ * other positions with 0. Monsters are not taken into account.
+ */
+typedef struct map_areas
+{
+    guint16 label[MAP_MAX_Y][MAP_MAX_X];
+    guint32 revision;
+    gboolean valid;
+} map_areas;
+
+/* get the connected areas of a map, updating them if necessary */
+static map_areas *map_areas_get(map *m, map_element_t element)
+{
+    if (m->areas[element] == NULL)
+        m->areas[element] = g_malloc0(sizeof(map_areas));
+
+    map_areas *ma = m->areas[element];
+    guint16 next = 0;
+    position pos = pos_invalid;
+    position stack[MAP_SIZE];
+
+    if (ma->valid && ma->revision == m->revision)
+    {
+        /* still up to date */
+        return ma;
+    }
+
+    memset(ma->label, 0, sizeof(ma->label));
+
+    Z(pos) = m->nlevel;
+    for (Y(pos) = 0; Y(pos) < MAP_MAX_Y; Y(pos)++)
+    {
+        for (X(pos) = 0; X(pos) < MAP_MAX_X; X(pos)++)
+        {
+            if (ma->label[Y(pos)][X(pos)]
+                    || !map_pos_passable_by(m, pos, element))
+                continue;
+
+            /* flood fill a new area; positions are labelled when
+               pushed, thus each of them is pushed only once */
+            guint len = 0;
+
+            ma->label[Y(pos)][X(pos)] = ++next;
+            stack[len++] = pos;
+
+            while (len > 0)
+            {
+                position curr = stack[--len];
+
+                for (direction dir = GD_NONE + 1; dir < GD_MAX; dir++)
+                {
+                    if (dir == GD_CURR)
+                        continue;
+
+                    position npos = pos_move(curr, dir);
+
+                    if (!pos_valid(npos) || ma->label[Y(npos)][X(npos)]
+                            || !map_pos_passable_by(m, npos, element))
+                        continue;
+
+                    ma->label[Y(npos)][X(npos)] = next;
+                    stack[len++] = npos;
+                }
+            }
+        }
+    }
+
+    ma->revision = m->revision;
+    ma->valid = TRUE;
+
+    return ma;
+}
+
+/* check if the goal might be reachable from the start */
+static gboolean map_pos_connected(map *m, position start, position goal,
+                                  map_element_t element)
+{
+    if (pos_identical(start, goal))
+        return TRUE;
+
+    map_areas *ma = map_areas_get(m, element);
+    guint16 from = ma->label[Y(start)][X(start)];
+    guint16 to = ma->label[Y(goal)][X(goal)];
+
+    /* the start does not have to be enterable, the goal has to be */
+    return (to != 0) && (from == 0 || from == to);
+}
+
+/*
+ * Path finding benchmark
+ */
+
+/* queries per map and the number of goals they share */
+#define MAP_BENCH_QUERIES 16
+#define MAP_BENCH_GOALS   4
+
+typedef enum map_bench_algorithm
+{
+    MAP_BENCH_ASTAR,    /* map_find_path() without jump point search */
+    MAP_BENCH_JPS,      /* map_find_path() with jump point search */
+    MAP_BENCH_BATCH,    /* map_find_paths() */
+    MAP_BENCH_MAX
+} map_bench_algorithm;
+
+typedef struct map_bench_result
+{
+    GArray *times;      /* microseconds per query */
+    guint found;        /* paths found */
+    guint errors;       /* invalid or longer paths, missing or unexpected paths */
+} map_bench_result;
+
+/* the cost of a step onto each position or -1 if it cannot be entered */
+typedef struct map_bench_reference
+{
+    gint32 cost[MAP_MAX_Y][MAP_MAX_X];
+    gint32 dist[MAP_MAX_Y][MAP_MAX_X];  /* the cost of the way to the goal */
+} map_bench_reference;
+
+/*
+ * Determine the cost of the cheapest way from every position to the goal
+ * by relaxing the distances of all positions until none of them changes.
+ * This is slow but leaves little room for mistakes.
+ */
+static void map_bench_reference_set(map *m, map_bench_reference *ref,
+                                    position goal, map_element_t element)
+{
+    position pos = pos_invalid;
+    gboolean changed = TRUE;
+
+    Z(pos) = m->nlevel;
+    for (Y(pos) = 0; Y(pos) < MAP_MAX_Y; Y(pos)++)
+    {
+        for (X(pos) = 0; X(pos) < MAP_MAX_X; X(pos)++)
+        {
+            map_path_element el = { .pos = pos };
+
+            ref->dist[Y(pos)][X(pos)] = MAP_DMAP_UNREACHABLE;
+            ref->cost[Y(pos)][X(pos)] = monster_valid_dest(m, pos, element)
+                                        ? map_step_cost(m, &el, element, FALSE)
+                                        : -1;
+        }
+    }
+
+    ref->dist[Y(goal)][X(goal)] = 0;
+
+    for (int sweep = 0; changed; sweep++)
+    {
+        changed = FALSE;
+
+        /* alternate the direction of the sweeps to converge faster */
+        for (int idx = 0; idx < MAP_SIZE; idx++)
+        {
+            const int cell = (sweep % 2) ? MAP_SIZE - 1 - idx : idx;
+            const int x = cell % MAP_MAX_X, y = cell / MAP_MAX_X;
+
+            for (int ny = max(y - 1, 0); ny <= min(y + 1, MAP_MAX_Y - 1); ny++)
+            {
+                for (int nx = max(x - 1, 0); nx <= min(x + 1, MAP_MAX_X - 1); nx++)
+                {
+                    if ((nx == x && ny == y) || ref->cost[ny][nx] < 0
+                            || ref->dist[ny][nx] == MAP_DMAP_UNREACHABLE)
+                        continue;
+
+                    const gint32 dist = ref->dist[ny][nx] + ref->cost[ny][nx];
+
+                    if (dist < ref->dist[y][x])
+                    {
+                        ref->dist[y][x] = dist;
+                        changed = TRUE;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/* check a path; returns the cost of the path or -1 if it is invalid */
+static gint32 map_bench_path_cost(map_bench_reference *ref, map_path *path)
+{
+    position prev = path->start;
+    gint32 cost = 0;
+
+    for (GList *iter = path->path->head; iter != NULL; iter = iter->next)
+    {
+        position pos = ((map_path_element *)iter->data)->pos;
+
+        if (!pos_adjacent(prev, pos) || ref->cost[Y(pos)][X(pos)] < 0)
+            return -1;
+
+        cost += ref->cost[Y(pos)][X(pos)];
+        prev = pos;
+    }
+
+    return pos_identical(prev, path->goal) ? cost : -1;
+}
+
+/* run the queries of a map with map_find_path() */
+static void map_bench_single(map *m, map_bench_reference *refs,
+                             map_path_query *queries, guint *goal_idx,
+                             map_bench_result *result, gboolean jps)
+{
+    map_path_jps_set(jps);
+
+    for (guint idx = 0; idx < MAP_BENCH_QUERIES; idx++)
+    {
+        map_path_query *q = &queries[idx];
+        map_bench_reference *ref = &refs[goal_idx[idx]];
+        const gint32 best = ref->dist[Y(q->start)][X(q->start)];
+
+        gint64 start = g_get_monotonic_time();
+        map_path *path = map_find_path(m, q->start, q->goal, q->element);
+        gint64 time = g_get_monotonic_time() - start;
+
+        g_array_append_val(result->times, time);
+
+        if (path == NULL)
+        {
+            /* there must not be a way */
+            if (best != MAP_DMAP_UNREACHABLE)
+                result->errors++;
+
+            continue;
+        }
+
+        gint32 cost = map_bench_path_cost(ref, path);
+        map_path_destroy(path);
+
+        result->found++;
+
+        /* both algorithms have to find one of the cheapest ways */
+        if (cost != best)
+            result->errors++;
+    }
+}
+
+/* run the queries of a map with map_find_paths() */
+static void map_bench_batch(map *m, map_bench_reference *refs,
+                            map_path_query *queries, guint *goal_idx,
+                            map_bench_result *result)
+{
+    gint64 start = g_get_monotonic_time();
+    map_find_paths(m, queries, MAP_BENCH_QUERIES);
+    gint64 time = (g_get_monotonic_time() - start) / MAP_BENCH_QUERIES;
+
+    for (guint idx = 0; idx < MAP_BENCH_QUERIES; idx++)
+    {
+        map_path_query *q = &queries[idx];
+        map_bench_reference *ref = &refs[goal_idx[idx]];
+        const gint32 best = ref->dist[Y(q->start)][X(q->start)];
+
+        g_array_append_val(result->times, time);
+
+        if (!pos_valid(q->step))
+        {
+            if (best != MAP_DMAP_UNREACHABLE)
+                result->errors++;
+
+            continue;
+        }
+
+        result->found++;
+
+        /* the step has to be on one of the cheapest ways */
+        if (!pos_identical(q->step, q->start)
+                && (!pos_adjacent(q->start, q->step)
+                    || ref->cost[Y(q->step)][X(q->step)] < 0
+                    || ref->dist[Y(q->step)][X(q->step)] == MAP_DMAP_UNREACHABLE
+                    || ref->cost[Y(q->step)][X(q->step)]
+                       + ref->dist[Y(q->step)][X(q->step)] != best))
+            result->errors++;
+
+        /* staying is only correct at the goal */
+        if (pos_identical(q->step, q->start) && best != 0)
+            result->errors++;
+
+        /* map_path_query_current() relies on the cost */
+        if (q->cost != best)
+            result->errors++;
+    }
+}
+
+/* run random queries on a map with all algorithms */
+static void map_bench_run(map *m, map_bench_reference *refs,
+                          map_bench_result *results)
+{
+    const map_element_t elements[] =
+    {
+        LE_GROUND, LE_MONSTER, LE_SWIMMING_MONSTER, LE_FLYING_MONSTER, LE_XORN
+    };
+
+    map_path_query goals[MAP_BENCH_GOALS];
+    map_path_query queries[MAP_BENCH_QUERIES];
+    guint goal_idx[MAP_BENCH_QUERIES];
+
+    for (guint idx = 0; idx < MAP_BENCH_GOALS; idx++)
+    {
+        goals[idx].goal = map_find_space(m, LE_ITEM, FALSE);
+        goals[idx].element = elements[rand_0n(G_N_ELEMENTS(elements))];
+
+        /* the batch search expects the goals to be on the map */
+        if (!pos_valid(goals[idx].goal))
+            return;
+
+        map_bench_reference_set(m, &refs[idx], goals[idx].goal,
+                                goals[idx].element);
+    }
+
+    for (guint idx = 0; idx < MAP_BENCH_QUERIES; idx++)
+    {
+        goal_idx[idx] = rand_0n(MAP_BENCH_GOALS);
+        queries[idx].start = map_find_space(m, LE_MONSTER, FALSE);
+        queries[idx].goal = goals[goal_idx[idx]].goal;
+        queries[idx].element = goals[goal_idx[idx]].element;
+
+        if (!pos_valid(queries[idx].start))
+            return;
+    }
+
+    map_bench_single(m, refs, queries, goal_idx, &results[MAP_BENCH_ASTAR], FALSE);
+    map_bench_single(m, refs, queries, goal_idx, &results[MAP_BENCH_JPS], TRUE);
+    map_bench_batch(m, refs, queries, goal_idx, &results[MAP_BENCH_BATCH]);
+}
+
+static int map_bench_time_cmp(const void *a, const void *b)
+{
+    const gint64 ta = *(const gint64 *)a, tb = *(const gint64 *)b;
+
+    return (ta > tb) - (ta < tb);
+}
+
+gboolean map_benchmark_paths(int maps)
+{
+    const char *names[MAP_BENCH_MAX] = { "A*", "A* + JPS", "batch" };
+    const gboolean jps = path_jps;
+
+    map_bench_reference *refs = g_new(map_bench_reference, MAP_BENCH_GOALS);
+    map_bench_result results[MAP_BENCH_MAX] = { { NULL, 0, 0 } };
+    gboolean success = TRUE;
+
+    for (int idx = 0; idx < MAP_BENCH_MAX; idx++)
+        results[idx].times = g_array_new(FALSE, FALSE, sizeof(gint64));
+
+    g_print("Finding paths on %d mazes and %d random maps, "
+            "%d queries each\n\n", MAP_MAZE_NUM, maps, MAP_BENCH_QUERIES);
+
+    for (int idx = 0; idx < MAP_MAZE_NUM + maps; idx++)
+    {
+        /* keep the town the player is on */
+        const int num = 1 + idx % (MAP_MAX - 1);
+        map *m;
+
+        map_destroy(nlarn->maps[num]);
+
+        if (idx < MAP_MAZE_NUM)
+            m = map_new_maze(num, nlarn->mazefile, idx);
+        else
+            while (!(m = map_new(num, nlarn->mazefile)));
+
+        if (m == NULL)
+        {
+            g_printerr("Failed to load maze %d.\n", idx);
+            success = FALSE;
+
+            /* the map is expected to exist */
+            while (!map_new(num, nlarn->mazefile));
+            continue;
+        }
+
+        map_bench_run(m, refs, results);
+    }
+
+    map_path_jps_set(jps);
+
+    g_print("%-10s %8s %8s %8s %10s %9s %9s\n", "algorithm", "queries",
+            "found", "errors", "queries/s", "mean us", "p99 us");
+
+    for (int idx = 0; idx < MAP_BENCH_MAX; idx++)
+    {
+        GArray *times = results[idx].times;
+        gint64 total = 0;
+
+        for (guint t = 0; t < times->len; t++)
+            total += g_array_index(times, gint64, t);
+
+        qsort(times->data, times->len, sizeof(gint64), map_bench_time_cmp);
+
+        g_print("%-10s %8u %8u %8u %10.0f %9.1f %9ld\n", names[idx],
+                times->len, results[idx].found, results[idx].errors,
+                times->len * (double)G_USEC_PER_SEC / max(total, 1),
+                (double)total / max(times->len, 1),
+                (long)(times->len ? g_array_index(times, gint64,
+                                                  times->len * 99 / 100) : 0));
+
+        if (results[idx].errors > 0)
+            success = FALSE;
+
+        g_array_free(times, TRUE);
+    }
+
+    g_free(refs);
+
+    return success;
 }
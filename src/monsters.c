@@ -69,6 +69,8 @@ struct _monster
     item *eq_weapon;
     GPtrArray *effects;
     guint number;        /* random value for some monsters */
+    map_path_query path; /* the way planned together with other monsters */
+    guint32 path_turn;   /* the game turn the way has been planned for */
     guint32
         unknown: 1;      /* monster is unknown (mimic) */
 };
@@ -755,6 +757,7 @@ static position monster_move_attack(monster *m, struct player *p);
 static position monster_move_confused(monster *m, struct player *p);
 static position monster_move_flee(monster *m, struct player *p);
 static position monster_move_serve(monster *m, struct player *p);
+static gboolean monster_path_planned(monster *m, position goal, position *step);
 static position monster_move_civilian(monster *m, struct player *p);
 
 static gboolean monster_breath_hit(const GList *traj,
@@ -1084,21 +1087,20 @@ void monster_serialize(gpointer oid, monster *m, cJSON *root)
     }
 }
 
-void monster_deserialize(cJSON *mser, game *g)
+monster *monster_deserialize(cJSON *mser)
 {
     cJSON *obj;
-    guint oid;
     monster *m = g_malloc0(sizeof(monster));
 
     m->type = cJSON_GetObjectItem(mser, "type")->valueint;
-    oid = cJSON_GetObjectItem(mser, "oid")->valueint;
-    m->oid = GUINT_TO_POINTER(oid);
+    m->oid = GUINT_TO_POINTER(cJSON_GetObjectItem(mser, "oid")->valueint);
     m->hp_max = cJSON_GetObjectItem(mser, "hp_max")->valueint;
     m->hp = cJSON_GetObjectItem(mser, "hp")->valueint;
     pos_val(m->pos) = cJSON_GetObjectItem(mser, "pos")->valueint;
     m->movement = cJSON_GetObjectItem(mser, "movement")->valueint;
     m->action = cJSON_GetObjectItem(mser, "action")->valueint;
 
+    /* only looks up the item table, which is complete at this point */
     if ((obj = cJSON_GetObjectItem(mser, "eq_weapon")))
         m->eq_weapon = game_item_get(nlarn, GUINT_TO_POINTER(obj->valueint));
 
@@ -1126,15 +1128,7 @@ void monster_deserialize(cJSON *mser, game *g)
     else
         m->effects = g_ptr_array_new();
 
-    /* add monster to game */
-    g_hash_table_insert(g->monsters, m->oid, m);
-
-    /* increase max_id to match used ids */
-    if (oid > g->monster_max_id)
-        g->monster_max_id = oid;
-
-    /* increment the count of monsters of the map the monster is on */
-    game_map(g, Z(m->pos))->mcount++;
+    return m;
 }
 
 int monster_hp_max(monster *m)
@@ -1187,22 +1181,12 @@ int monster_valid_dest(map *m, position pos, int map_elem)
     if (map_elem == LE_GROUND && pos_identical(pos, nlarn->p->pos))
         return FALSE;
 
-    switch (map_tiletype_at(m, pos))
-    {
-    case LT_WALL:
-        return (map_elem == LE_XORN);
-
-    case LT_DEEPWATER:
-        if (map_elem == LE_SWIMMING_MONSTER)
-            return TRUE;
-        // else fall through
-    case LT_LAVA:
-        return (map_elem == LE_FLYING_MONSTER);
+    if (!map_pos_passable_by(m, pos, map_elem))
+        return FALSE;
 
-    default:
-        /* the map tile must be passable and there must be no monster on it*/
-        return (map_pos_passable(m, pos) && !map_is_monster_at(m, pos));
-    }
+    /* there must be no monster on a regularly passable tile; walls,
+       deep water and lava are not checked for monsters */
+    return (!map_pos_passable(m, pos) || !map_is_monster_at(m, pos));
 }
 
 int monster_pos_set(monster *m, map *mp, position target)
@@ -1767,6 +1751,80 @@ void monster_move(gpointer *oid __attribute__((unused)), monster *m, game *g)
     if (m->lastseen) m->lastseen++;
 }
 
+/* the ways of the monsters of a map collected to be planned together */
+typedef struct _monster_path_batch
+{
+    game *g;
+    GArray *queries;
+    GPtrArray *monsters;
+} monster_path_batch;
+
+static void monster_path_collect(gpointer oid __attribute__((unused)),
+                                 monster *m, monster_path_batch *batch)
+{
+    position goal = pos_invalid;
+    player *p = batch->g->p;
+
+    if (monster_hp(m) < 1 || Z(m->pos) != Z(p->pos))
+        return;
+
+    switch (monster_action(m))
+    {
+    case MA_ATTACK:
+        /* monsters that know where the player is use the distance map */
+        if (!pos_identical(m->player_pos, p->pos))
+            goal = m->player_pos;
+        break;
+
+    case MA_SERVE:
+        if (pos_distance(m->pos, p->pos) > 5)
+            goal = p->pos;
+        break;
+
+    case MA_CIVILIAN:
+        goal = m->player_pos;
+        break;
+
+    default:
+        break;
+    }
+
+    if (!pos_valid(goal) || pos_identical(goal, m->pos))
+        return;
+
+    map_path_query q = { m->pos, goal, monster_map_element(m),
+                         pos_invalid, 0, 0 };
+
+    g_array_append_val(batch->queries, q);
+    g_ptr_array_add(batch->monsters, m);
+}
+
+void monster_plan_paths(game *g)
+{
+    monster_path_batch batch =
+    {
+        g,
+        g_array_new(FALSE, FALSE, sizeof(map_path_query)),
+        g_ptr_array_new()
+    };
+
+    g_hash_table_foreach(g->monsters, (GHFunc)monster_path_collect, &batch);
+
+    map_find_paths(game_map(g, Z(g->p->pos)),
+                   (map_path_query *)batch.queries->data, batch.queries->len);
+
+    for (guint idx = 0; idx < batch.monsters->len; idx++)
+    {
+        monster *m = g_ptr_array_index(batch.monsters, idx);
+
+        m->path = g_array_index(batch.queries, map_path_query, idx);
+        m->path_turn = game_turn(g);
+    }
+
+    g_array_free(batch.queries, TRUE);
+    g_ptr_array_free(batch.monsters, TRUE);
+}
+
 void monster_polymorph(monster *m)
 {
     g_assert (m != NULL);
@@ -2850,7 +2908,7 @@ static gboolean monster_player_visible(monster *m)
         return FALSE;
 
     /* determine if player's position is visible from monster's position */
-    return map_pos_is_visible(monster_map(m), m->pos, nlarn->p->pos);
+    return map_pos_is_visible_cached(monster_map(m), m->pos, nlarn->p->pos);
 }
 
 static gboolean monster_attack_available(monster *m, attack_t type)
@@ -3170,6 +3228,26 @@ static position monster_move_wander(monster *m, struct player *p __attribute__((
     return npos;
 }
 
+/* get the step planned by monster_plan_paths() if it is still usable */
+static gboolean monster_path_planned(monster *m, position goal, position *step)
+{
+    if (m->path_turn != game_turn(nlarn)
+            || !pos_identical(m->path.start, m->pos)
+            || !pos_identical(m->path.goal, goal)
+            || m->path.element != (map_element_t)monster_map_element(m))
+        return FALSE;
+
+    /* Monsters that have moved before may block the way or may have
+       cleared a cheaper one; both require a new search. */
+    if (!pos_valid(m->path.step) || pos_identical(m->path.step, m->pos)
+            || !map_path_query_current(monster_map(m), &m->path))
+        return FALSE;
+
+    *step = m->path.step;
+
+    return TRUE;
+}
+
 static position monster_move_attack(monster *m, struct player *p)
 {
     /* path to player */
@@ -3200,48 +3278,39 @@ static position monster_move_attack(monster *m, struct player *p)
     if (pos_identical(monster_pos(m), m->player_pos)
             && map_is_exit_at(monster_map(m), monster_pos(m)))
     {
-        int newmap;
-
-        switch (map_sobject_at(monster_map(m), monster_pos(m)))
-        {
-        case LS_STAIRSDOWN:
-        case LS_DNGN_ENTRANCE:
-            newmap = Z(m->pos) + 1;
-            break;
+        position target = map_exit_target(monster_map(m), monster_pos(m));
 
-        case LS_STAIRSUP:
-        case LS_DNGN_EXIT:
-            newmap = Z(m->pos) - 1;
-            break;
-
-        case LS_ELEVATORDOWN:
-            /* move into the volcano from the town */
-            newmap = MAP_DMAX + 1;
-            break;
+        /* change the map */
+        if (pos_valid(target))
+            monster_level_enter(m, game_map(nlarn, Z(target)));
 
-        case LS_ELEVATORUP:
-            /* volcano monster enters the town */
-            newmap = 0;
-            break;
+        return monster_pos(m);
+    }
 
-        default:
-            newmap = Z(m->pos);
-            break;
-        }
+    /* monster heads into the direction of the player: a monster that
+       knows where the player is follows the distances shared by all
+       monsters on the map */
+    if (pos_identical(m->player_pos, p->pos))
+    {
+        npos = map_step_to_player(monster_map(m), monster_pos(m),
+                                  monster_map_element(m));
 
-        /* change the map */
-        monster_level_enter(m, game_map(nlarn, newmap));
+        if (pos_valid(npos))
+            return npos;
 
-        return monster_pos(m);
+        /* the way is blocked, look for a way around */
+        npos = monster_pos(m);
     }
 
-    /* monster heads into the direction of the player. */
+    if (monster_path_planned(m, m->player_pos, &npos))
+        return npos;
+
     path = map_find_path(monster_map(m), monster_pos(m), m->player_pos,
                          monster_map_element(m));
 
     if (path && !g_queue_is_empty(path->path))
     {
-        el = g_queue_pop_head(path->path);
+        el = g_queue_peek_head(path->path);
         npos = el->pos;
     }
     else
@@ -3269,7 +3338,17 @@ static position monster_move_flee(monster *m, struct player *p)
 {
     int dist = 0;
     position npos_tmp;
-    position npos = monster_pos(m);
+    position npos;
+
+    /* follow the safety map shared by all fleeing monsters */
+    npos = map_step_from_player(monster_map(m), monster_pos(m),
+                                monster_map_element(m));
+
+    if (pos_valid(npos))
+        return npos;
+
+    /* the safer positions are occupied, try to get away anyhow */
+    npos = monster_pos(m);
 
     for (int tries = 1; tries < GD_MAX; tries++)
     {
@@ -3312,17 +3391,20 @@ static position monster_move_serve(monster *m, struct player *p)
     if (pos_distance(monster_pos(m), p->pos) > 5)
     {
         /* if the distance to the player is too large, follow */
-        map_path *path = map_find_path(monster_map(m), monster_pos(m), p->pos,
-                                       monster_map_element(m));
-
-        if (path && !g_queue_is_empty(path->path))
+        if (!monster_path_planned(m, p->pos, &npos))
         {
-            map_path_element *pe = g_queue_pop_head(path->path);
-            npos = pe->pos;
-        }
+            map_path *path = map_find_path(monster_map(m), monster_pos(m),
+                                           p->pos, monster_map_element(m));
 
-        if (path != NULL)
-            map_path_destroy(path);
+            if (path && !g_queue_is_empty(path->path))
+            {
+                map_path_element *pe = g_queue_peek_head(path->path);
+                npos = pe->pos;
+            }
+
+            if (path != NULL)
+                map_path_destroy(path);
+        }
     }
     else
     {
@@ -3362,6 +3444,14 @@ static position monster_move_civilian(monster *m, struct player *p)
            enough, thus reset the target position. */
         m->player_pos = pos_invalid;
     }
+    else if (pos_valid(m->player_pos) && !pos_identical(m->pos, m->player_pos)
+             && monster_path_planned(m, m->player_pos, &npos))
+    {
+        /* the new position is identical to the target, thus reset
+           the lastseen counter */
+        if (pos_identical(npos, m->player_pos))
+            m->lastseen = 1;
+    }
     else if (pos_valid(m->player_pos) && !pos_identical(m->pos, m->player_pos))
     {
         /* travel to the selected location */
@@ -3369,7 +3459,7 @@ static position monster_move_civilian(monster *m, struct player *p)
 
         if (path && !g_queue_is_empty(path->path))
         {
-            map_path_element *pe = g_queue_pop_head(path->path);
+            map_path_element *pe = g_queue_peek_head(path->path);
             npos = pe->pos;
 
             if (pos_identical(npos, m->player_pos))
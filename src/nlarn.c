@@ -65,6 +65,12 @@ int main(int argc, char *argv[])
     /* position chosen for auto travel, allowing to continue travel */
     position cpos = pos_invalid;
 
+    /* the map auto travel currently leads through */
+    guint tmap = 0;
+
+    /* the way to the auto travel destination */
+    map_route *route = NULL;
+
     /* initialise the game */
     game_init(argc, argv);
 
@@ -131,6 +137,13 @@ int main(int argc, char *argv[])
         /* repaint screen */
         display_paint_screen(nlarn->p);
 
+        /* forget the way to a former travel destination */
+        if (route != NULL && !pos_identical(route->goal, pos))
+        {
+            map_route_destroy(route);
+            route = NULL;
+        }
+
         if (pos_valid(pos))
         {
             /* travel mode */
@@ -138,7 +151,7 @@ int main(int argc, char *argv[])
             /* check if travel mode shall be aborted:
                attacked or fell through trap door */
             if (nlarn->p->attacked || player_adjacent_monster(nlarn->p, FALSE)
-                || Z(pos) != Z(nlarn->p->pos))
+                || tmap != Z(nlarn->p->pos))
             {
                 pos = pos_invalid;
             }
@@ -151,15 +164,17 @@ int main(int argc, char *argv[])
             }
             else
             {
-                /* find a path to the destination */
-                map_path *path = map_find_path(game_map(nlarn, Z(nlarn->p->pos)),
-                                               nlarn->p->pos, pos, LE_GROUND);
+                /* follow the way to the destination */
+                if (route == NULL)
+                    route = map_route_new(pos, LE_GROUND);
+
+                position npos = map_route_next(route, game_map(nlarn, Z(nlarn->p->pos)),
+                                               nlarn->p->pos);
 
-                if (path && !g_queue_is_empty(path->path))
+                if (pos_valid(npos) && !pos_identical(npos, nlarn->p->pos))
                 {
                     /* Path found. Move the player. */
-                    map_path_element *el = g_queue_pop_head(path->path);
-                    moves_count = player_move(nlarn->p, pos_dir(nlarn->p->pos, el->pos), TRUE);
+                    moves_count = player_move(nlarn->p, pos_dir(nlarn->p->pos, npos), TRUE);
 
                     if (moves_count == 0)
                     {
@@ -168,14 +183,27 @@ int main(int argc, char *argv[])
                         pos = pos_invalid;
                     }
                 }
+                else if (pos_valid(npos) && Z(pos) != Z(nlarn->p->pos))
+                {
+                    /* standing on the map exit towards the destination */
+                    position target = map_exit_target(game_map(nlarn, Z(nlarn->p->pos)),
+                                                      nlarn->p->pos);
+
+                    if (Z(target) > Z(nlarn->p->pos))
+                        moves_count = player_stairs_down(nlarn->p);
+                    else
+                        moves_count = player_stairs_up(nlarn->p);
+
+                    if (moves_count == 0)
+                        pos = pos_invalid;
+                    else
+                        tmap = Z(nlarn->p->pos);
+                }
                 else
                 {
                     /* No path found. Stop traveling */
                     pos = pos_invalid;
                 }
-
-                /* clean up */
-                if (path) map_path_destroy(path);
             }
         }
         else if (run_cmd != 0)
@@ -439,16 +467,12 @@ int main(int argc, char *argv[])
 
             /* continue auto travel */
         case 'C':
-            /* delete last auto travel target if it was on another map */
-            if (Z(cpos) != Z(nlarn->p->pos))
-            {
-                cpos = pos_invalid;
-            }
-
+            /* the target might be on another map */
             if (pos_valid(cpos))
             {
                 /* restore last known auto travel position */
                 pos = cpos;
+                tmap = Z(nlarn->p->pos);
                 /* reset keyboard input */
                 ch = 0;
             }
@@ -587,6 +611,7 @@ int main(int argc, char *argv[])
                 ch = 0;
                 /* store position for resuming travel */
                 cpos = pos;
+                tmap = Z(nlarn->p->pos);
             }
             else
             {
@@ -114,9 +114,11 @@ static inline void player_item_pickup_ask(player *p, inventory **inv, item *it)
 }
 
 static void player_sobject_memorize(player *p, sobject_t sobject, position pos);
+static void player_memorize_tile(player *p, map *pmap, position pos);
+static void player_memorize_items(player *p, map *pmap, position pos);
 static int player_sobjects_sort(gconstpointer a, gconstpointer b);
-static cJSON *player_memory_serialize(player *p, position pos);
-static void player_memory_deserialize(player *p, position pos, cJSON *mser);
+static cJSON *player_memory_serialize(player *p, int nmap);
+static void player_memory_deserialize(player *p, int nmap, cJSON *mser);
 static char *player_equipment_list(player *p, gboolean decorate);
 static char *player_create_obituary(player *p, score_t *score, GList *scores);
 static void player_memorial_file_save(player *p, const char *text);
@@ -334,7 +336,7 @@ void player_destroy(player *p)
     g_free(p);
 }
 
-cJSON *player_serialize(player *p)
+cJSON *player_serialize(player *p, gboolean memory)
 {
     cJSON *obj;
     cJSON *pser = cJSON_CreateObject();
@@ -461,20 +463,13 @@ cJSON *player_serialize(player *p)
         cJSON_AddNumberToObject(pser, "ptarget", GPOINTER_TO_UINT(p->ptarget));
     }
 
-    position pos = pos_invalid;
-
     /* store players' memory of the map */
-    cJSON_AddItemToObject(pser, "memory", obj = cJSON_CreateArray());
-
-    for (Z(pos) = 0; Z(pos) < MAP_MAX; Z(pos)++)
+    if (memory)
     {
-        cJSON *mm = cJSON_CreateArray();
-
-        for (Y(pos) = 0; Y(pos) < MAP_MAX_Y; Y(pos)++)
-            for (X(pos) = 0; X(pos) < MAP_MAX_X; X(pos)++)
-                cJSON_AddItemToArray(mm, player_memory_serialize(p, pos));
+        cJSON_AddItemToObject(pser, "memory", obj = cJSON_CreateArray());
 
-        cJSON_AddItemToArray(obj, mm);
+        for (int nmap = 0; nmap < MAP_MAX; nmap++)
+            cJSON_AddItemToArray(obj, player_memory_serialize(p, nmap));
     }
 
     /* store remembered stationary objects */
@@ -669,23 +664,13 @@ player *player_deserialize(cJSON *pser)
         p->ptarget = GUINT_TO_POINTER(obj->valueint);
     }
 
-    /* restore players' memory of the map */
-    position pos = pos_invalid;
+    /* restore players' memory of the map
+       (binary saved games store it separately) */
     obj = cJSON_GetObjectItem(pser, "memory");
+    elem = (obj != NULL) ? obj->child : NULL;
 
-    for (Z(pos) = 0; Z(pos) < MAP_MAX; Z(pos)++)
-    {
-        elem = cJSON_GetArrayItem(obj, Z(pos));
-
-        for (Y(pos) = 0; Y(pos) < MAP_MAX_Y; Y(pos)++)
-        {
-            for (X(pos) = 0; X(pos) < MAP_MAX_X; X(pos)++)
-            {
-                cJSON *tile = cJSON_GetArrayItem(elem, X(pos) + (MAP_MAX_X * Y(pos)));
-                player_memory_deserialize(p, pos, tile);
-            }
-        }
-    }
+    for (int nmap = 0; elem != NULL && nmap < MAP_MAX; nmap++, elem = elem->next)
+        player_memory_deserialize(p, nmap, elem);
 
     /* remembered stationary objects */
     obj = cJSON_GetObjectItem(pser, "sobjmem");
@@ -1667,7 +1652,7 @@ int player_map_enter(player *p, map *l, gboolean teleported)
     /* automatic save point */
     if (game_autosave(nlarn) && (game_turn(nlarn) > 1))
     {
-        game_save(nlarn);
+        game_save_background(nlarn);
     }
 
     return TRUE;
@@ -4395,12 +4380,13 @@ void player_update_fov(player *p)
                     gboolean mchk = ((pos_distance(p->pos, pos) <= 7)
                                     && map_pos_is_visible(pmap, p->pos, pos));
 
-                    fov_set(p->fv, pos, TRUE, infravision, mchk);
+                    fov_set(p->fv, pos, TRUE, mchk);
                 }
             }
         }
 
         area_destroy(enlight);
+        fov_find_monsters(p->fv, pmap, infravision);
     }
     else
     {
@@ -4408,80 +4394,21 @@ void player_update_fov(player *p)
         fov_calculate(p->fv, pmap, p->pos, radius, infravision);
     }
 
-    /* update visible fields in player's memory */
-    for (Y(pos) = 0; Y(pos) < MAP_MAX_Y; Y(pos)++)
-    {
-        for (X(pos) = 0; X(pos) < MAP_MAX_X; X(pos)++)
-        {
-            if (fov_get(p->fv, pos))
-            {
-                monster *m = map_get_monster_at(pmap, pos);
-                inventory **inv = map_ilist_at(pmap, pos);
+    GArray *visible = fov_get_visible(p->fv);
+    GArray *gained = fov_get_gained(p->fv);
 
-                player_memory_of(p,pos).type = map_tiletype_at(pmap, pos);
-                player_memory_of(p,pos).sobject = map_sobject_at(pmap, pos);
+    /* The stationary parts of positions that have been visible before
+       are known already unless the map has changed. Items may have been
+       moved around in plain sight, thus the memory of these is updated
+       for all visible positions. */
+    if (gained == NULL)
+        gained = visible;
 
-                /* remember certain stationary objects */
-                switch (map_sobject_at(pmap, pos))
-                {
-                case LS_ALTAR:
-                case LS_BANK2:
-                case LS_FOUNTAIN:
-                case LS_MIRROR:
-                case LS_THRONE:
-                case LS_THRONE2:
-                case LS_STATUE:
-                    player_sobject_memorize(p, map_sobject_at(pmap, pos), pos);
-                    break;
-
-                default:
-                    player_sobject_forget(p, pos);
-                    break;
-                }
+    for (guint idx = 0; idx < gained->len; idx++)
+        player_memorize_tile(p, pmap, g_array_index(gained, position, idx));
 
-                if (m && monster_flags(m, MIMIC) && monster_unknown(m))
-                {
-                    /* remember the undiscovered mimic as an item */
-                    item *it = get_mimic_item(m);
-                    if (it != NULL)
-                    {
-                        player_memory_of(p,pos).item = it->type;
-                        player_memory_of(p,pos).item_colour = item_colour(it);
-                    }
-                }
-                else if (inv_length(*inv) > 0)
-                {
-                    item *it;
-
-                    /* memorize the most interesting item on the tile */
-                    if (inv_length_filtered(*inv, item_filter_gems) > 0)
-                    {
-                        /* there's a gem in the stack */
-                        it = inv_get_filtered(*inv, 0, item_filter_gems);
-                    }
-                    else if (inv_length_filtered(*inv, item_filter_gold) > 0)
-                    {
-                        /* there is gold in the stack */
-                        it = inv_get_filtered(*inv, 0, item_filter_gold);
-                    }
-                    else
-                    {
-                        /* memorize the topmost item on the stack */
-                        it = inv_get(*inv, inv_length(*inv) - 1);
-                    }
-
-                    player_memory_of(p,pos).item = it->type;
-                    player_memory_of(p,pos).item_colour = item_colour(it);
-                }
-                else
-                {
-                    /* no item at that position */
-                    player_memory_of(p,pos).item = IT_NONE;
-                    player_memory_of(p,pos).item_colour = 0;
-                }
-            }
-        }
-    }
+    for (guint idx = 0; idx < visible->len; idx++)
+        player_memorize_items(p, pmap, g_array_index(visible, position, idx));
 }
 
 static guint player_item_pickup(player *p, inventory **inv, item *it, gboolean ask)
@@ -4563,6 +4490,77 @@ static guint player_item_pickup(player *p, inventory **inv, item *it, gboolean a
     return 0;
 }
 
+static void player_memorize_tile(player *p, map *pmap, position pos)
+{
+    player_memory_of(p,pos).type = map_tiletype_at(pmap, pos);
+    player_memory_of(p,pos).sobject = map_sobject_at(pmap, pos);
+
+    /* remember certain stationary objects */
+    switch (map_sobject_at(pmap, pos))
+    {
+    case LS_ALTAR:
+    case LS_BANK2:
+    case LS_FOUNTAIN:
+    case LS_MIRROR:
+    case LS_THRONE:
+    case LS_THRONE2:
+    case LS_STATUE:
+        player_sobject_memorize(p, map_sobject_at(pmap, pos), pos);
+        break;
+
+    default:
+        player_sobject_forget(p, pos);
+        break;
+    }
+}
+
+static void player_memorize_items(player *p, map *pmap, position pos)
+{
+    monster *m = map_get_monster_at(pmap, pos);
+    inventory **inv = map_ilist_at(pmap, pos);
+
+    if (m && monster_flags(m, MIMIC) && monster_unknown(m))
+    {
+        /* remember the undiscovered mimic as an item */
+        item *it = get_mimic_item(m);
+        if (it != NULL)
+        {
+            player_memory_of(p,pos).item = it->type;
+            player_memory_of(p,pos).item_colour = item_colour(it);
+        }
+    }
+    else if (inv_length(*inv) > 0)
+    {
+        item *it;
+
+        /* memorize the most interesting item on the tile */
+        if (inv_length_filtered(*inv, item_filter_gems) > 0)
+        {
+            /* there's a gem in the stack */
+            it = inv_get_filtered(*inv, 0, item_filter_gems);
+        }
+        else if (inv_length_filtered(*inv, item_filter_gold) > 0)
+        {
+            /* there is gold in the stack */
+            it = inv_get_filtered(*inv, 0, item_filter_gold);
+        }
+        else
+        {
+            /* memorize the topmost item on the stack */
+            it = inv_get(*inv, inv_length(*inv) - 1);
+        }
+
+        player_memory_of(p,pos).item = it->type;
+        player_memory_of(p,pos).item_colour = item_colour(it);
+    }
+    else
+    {
+        /* no item at that position */
+        player_memory_of(p,pos).item = IT_NONE;
+        player_memory_of(p,pos).item_colour = 0;
+    }
+}
+
 static void player_sobject_memorize(player *p, sobject_t sobject, position pos)
 {
     player_sobject_memory nsom;
@@ -4630,17 +4628,12 @@ gboolean player_adjacent_monster(player *p, gboolean ignore_harmless)
     gboolean monster_visible = FALSE;
 
     /* get the list of all visible monsters */
-    GList *mlist, *miter;
-    miter = mlist = fov_get_visible_monsters(p->fv);
+    GPtrArray *mlist = fov_get_visible_monsters(p->fv);
 
-    /* no visible monsters? */
-    if (mlist == NULL)
-        return monster_visible;
-
-    /* got a list of monsters, check if any are dangerous */
-    do
+    /* check if any of the visible monsters are dangerous */
+    for (guint idx = 0; idx < mlist->len; idx++)
     {
-        monster *m = (monster *)miter->data;
+        monster *m = g_ptr_array_index(mlist, idx);
 
         // Ignore the town inhabitants.
         if (monster_type(m) == MT_TOWN_PERSON)
@@ -4666,10 +4659,6 @@ gboolean player_adjacent_monster(player *p, gboolean ignore_harmless)
         monster_visible = TRUE;
         break;
     }
-    while ((miter = miter->next) != NULL);
-
-    /* free the list returned by fov_get_visible_monsters() */
-    g_list_free(mlist);
 
     return monster_visible;
 }
@@ -4694,57 +4683,207 @@ static int player_sobjects_sort(gconstpointer a, gconstpointer b)
         return 1;
 }
 
-static cJSON *player_memory_serialize(player *p, position pos)
+/*
+ * The player's memory of a map is stored as separate planes for each
+ * field of player_tile_memory. Every plane is run-length encoded as
+ * most of the map is usually unexplored or uniform.
+ */
+enum memory_plane
+{
+    MP_TYPE,
+    MP_SOBJECT,
+    MP_ITEM,
+    MP_TRAP,
+    MP_COLOUR,
+    MP_MAX
+};
+
+static const char *memory_plane_names[MP_MAX] =
+{
+    "type", "sobject", "item", "trap", "item_colour"
+};
+
+/* number of bytes used to store a value of a plane in binary saved games */
+static const guint memory_plane_width[MP_MAX] = { 1, 1, 1, 1, 4 };
+
+static void player_memory_planes_get(player *p, int nmap,
+                                     guint32 planes[MP_MAX][MAP_SIZE])
+{
+    player_tile_memory *mem = &p->memory[nmap][0][0];
+
+    for (int idx = 0; idx < MAP_SIZE; idx++, mem++)
+    {
+        planes[MP_TYPE][idx] = mem->type;
+        planes[MP_SOBJECT][idx] = mem->sobject;
+        planes[MP_ITEM][idx] = mem->item;
+        planes[MP_TRAP][idx] = mem->trap;
+        planes[MP_COLOUR][idx] = mem->item_colour;
+    }
+}
+
+static void player_memory_planes_set(player *p, int nmap,
+                                     guint32 planes[MP_MAX][MAP_SIZE])
+{
+    player_tile_memory *mem = &p->memory[nmap][0][0];
+
+    for (int idx = 0; idx < MAP_SIZE; idx++, mem++)
+    {
+        mem->type = planes[MP_TYPE][idx];
+        mem->sobject = planes[MP_SOBJECT][idx];
+        mem->item = planes[MP_ITEM][idx];
+        mem->trap = planes[MP_TRAP][idx];
+        mem->item_colour = planes[MP_COLOUR][idx];
+    }
+}
+
+void player_memory_serialize_binary(player *p, int nmap, GByteArray *buf)
+{
+    guint32 planes[MP_MAX][MAP_SIZE];
+
+    player_memory_planes_get(p, nmap, planes);
+
+    for (int plane = 0; plane < MP_MAX; plane++)
+        sf_put_rle(buf, planes[plane], MAP_SIZE, memory_plane_width[plane]);
+}
+
+/* size of a single remembered tile in binary saved games before
+   format revision 3: type, sobject, item, trap, item colour (32 bit) */
+#define PLAYER_MEMORY_RECORD_LEN 8
+
+gboolean player_memory_deserialize_binary(player *p, int nmap,
+                                          savefile_reader *r, guint format)
+{
+    guint32 planes[MP_MAX][MAP_SIZE];
+
+    if (format >= 3)
+    {
+        for (int plane = 0; plane < MP_MAX; plane++)
+        {
+            if (!sf_get_rle(r, planes[plane], MAP_SIZE,
+                            memory_plane_width[plane]))
+                return FALSE;
+        }
+
+        player_memory_planes_set(p, nmap, planes);
+
+        return TRUE;
+    }
+
+    const guint8 *rec = sf_get_data(r, MAP_SIZE * PLAYER_MEMORY_RECORD_LEN);
+
+    if (rec == NULL)
+        return FALSE;
+
+    for (int idx = 0; idx < MAP_SIZE; idx++, rec += PLAYER_MEMORY_RECORD_LEN)
+    {
+        planes[MP_TYPE][idx] = rec[0];
+        planes[MP_SOBJECT][idx] = rec[1];
+        planes[MP_ITEM][idx] = rec[2];
+        planes[MP_TRAP][idx] = rec[3];
+        planes[MP_COLOUR][idx] = rec[4] | rec[5] << 8 | rec[6] << 16
+                                 | (guint32)rec[7] << 24;
+    }
+
+    player_memory_planes_set(p, nmap, planes);
+
+    return TRUE;
+}
+
+static cJSON *player_memory_serialize(player *p, int nmap)
 {
-    cJSON *mser;
+    guint32 planes[MP_MAX][MAP_SIZE];
+    cJSON *mser = cJSON_CreateObject();
 
-    mser = cJSON_CreateObject();
-    if (player_memory_of(p, pos).type > LT_NONE)
-        cJSON_AddNumberToObject(mser, "type",
-                                player_memory_of(p, pos).type);
+    player_memory_planes_get(p, nmap, planes);
 
-    if (player_memory_of(p, pos).sobject > LS_NONE)
-        cJSON_AddNumberToObject(mser, "sobject",
-                                player_memory_of(p, pos).sobject);
+    /* every plane is stored as pairs of run length and value */
+    for (int plane = 0; plane < MP_MAX; plane++)
+    {
+        cJSON *runs = cJSON_CreateArray();
+        const guint32 *values = planes[plane];
 
-    if (player_memory_of(p, pos).item > IT_NONE)
-        cJSON_AddNumberToObject(mser, "item",
-                                player_memory_of(p, pos).item);
+        for (int idx = 0; idx < MAP_SIZE; )
+        {
+            int run = 1;
 
-    if (player_memory_of(p, pos).item_colour > 0)
-        cJSON_AddNumberToObject(mser, "item_colour",
-                                player_memory_of(p, pos).item_colour);
+            while (idx + run < MAP_SIZE && values[idx + run] == values[idx])
+                run++;
 
-    if (player_memory_of(p, pos).trap > TT_NONE)
-        cJSON_AddNumberToObject(mser, "trap",
-                                player_memory_of(p, pos).trap);
+            cJSON_AddItemToArray(runs, cJSON_CreateNumber(run));
+            cJSON_AddItemToArray(runs, cJSON_CreateNumber(values[idx]));
+
+            idx += run;
+        }
+
+        cJSON_AddItemToObject(mser, memory_plane_names[plane], runs);
+    }
 
     return mser;
 }
 
-static void player_memory_deserialize(player *p, position pos, cJSON *mser)
+static void player_memory_tile_deserialize(player_tile_memory *mem, cJSON *mser)
 {
     cJSON *obj;
 
     obj = cJSON_GetObjectItem(mser, "type");
     if (obj != NULL)
-        player_memory_of(p, pos).type = obj->valueint;
+        mem->type = obj->valueint;
 
     obj = cJSON_GetObjectItem(mser, "sobject");
     if (obj != NULL)
-        player_memory_of(p, pos).sobject = obj->valueint;
+        mem->sobject = obj->valueint;
 
     obj = cJSON_GetObjectItem(mser, "item");
     if (obj != NULL)
-        player_memory_of(p, pos).item = obj->valueint;
+        mem->item = obj->valueint;
 
     obj = cJSON_GetObjectItem(mser, "item_colour");
     if (obj != NULL)
-        player_memory_of(p, pos).item_colour = obj->valueint;
+        mem->item_colour = obj->valueint;
 
     obj = cJSON_GetObjectItem(mser, "trap");
     if (obj != NULL)
-        player_memory_of(p, pos).trap = obj->valueint;
+        mem->trap = obj->valueint;
+}
+
+static void player_memory_deserialize(player *p, int nmap, cJSON *mser)
+{
+    if (mser->type == cJSON_Array)
+    {
+        /* saved games of older versions store an object for every tile */
+        player_tile_memory *mem = &p->memory[nmap][0][0];
+        cJSON *tile = mser->child;
+
+        for (int idx = 0; tile != NULL && idx < MAP_SIZE;
+                idx++, tile = tile->next)
+        {
+            player_memory_tile_deserialize(&mem[idx], tile);
+        }
+
+        return;
+    }
+
+    guint32 planes[MP_MAX][MAP_SIZE] = { { 0 } };
+
+    for (int plane = 0; plane < MP_MAX; plane++)
+    {
+        cJSON *runs = cJSON_GetObjectItem(mser, memory_plane_names[plane]);
+        cJSON *run = (runs != NULL) ? runs->child : NULL;
+        int idx = 0;
+
+        while (run != NULL && run->next != NULL)
+        {
+            int count = run->valueint;
+            guint32 value = (guint32)run->next->valuedouble;
+
+            for (; count > 0 && idx < MAP_SIZE; count--)
+                planes[plane][idx++] = value;
+
+            run = run->next->next;
+        }
+    }
+
+    player_memory_planes_set(p, nmap, planes);
 }
 
 void calc_fighting_stats(player *p)
@@ -371,6 +371,9 @@ static int potion_amnesia(player *p, item *potion __attribute__((unused)))
         }
     }
 
+    /* have the visible positions memorized again */
+    fov_reset(p->fv);
+
     log_add_entry(nlarn->log, "You stagger for a moment...");
 
     return TRUE;
@@ -0,0 +1,250 @@
+/*
+ * savefile.c
+ * Copyright (C) 2009-2018 Joachim de Groot <jdegroot@web.de>
+ *
+ * NLarn is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * NLarn is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+#include <string.h>
+
+#include "savefile.h"
+
+void sf_put_u8(GByteArray *buf, guint8 val)
+{
+    g_byte_array_append(buf, &val, 1);
+}
+
+void sf_put_u16(GByteArray *buf, guint16 val)
+{
+    const guint8 bytes[2] = { val & 0xff, val >> 8 };
+    g_byte_array_append(buf, bytes, sizeof(bytes));
+}
+
+void sf_put_u32(GByteArray *buf, guint32 val)
+{
+    const guint8 bytes[4] =
+    {
+        val & 0xff, (val >> 8) & 0xff, (val >> 16) & 0xff, val >> 24
+    };
+
+    g_byte_array_append(buf, bytes, sizeof(bytes));
+}
+
+void sf_put_data(GByteArray *buf, gconstpointer data, gsize len)
+{
+    g_byte_array_append(buf, data, len);
+}
+
+void sf_put_header(GByteArray *buf)
+{
+    sf_put_data(buf, SAVEFILE_MAGIC, SAVEFILE_MAGIC_LEN);
+    sf_put_u8(buf, SAVEFILE_FORMAT);
+}
+
+void sf_put_rle(GByteArray *buf, const guint32 *values, guint count,
+                guint width)
+{
+    for (guint idx = 0; idx < count; )
+    {
+        guint run = 1;
+
+        while (idx + run < count && run < G_MAXUINT16
+                && values[idx + run] == values[idx])
+            run++;
+
+        sf_put_u16(buf, run);
+
+        if (width == 1)
+            sf_put_u8(buf, values[idx]);
+        else
+            sf_put_u32(buf, values[idx]);
+
+        idx += run;
+    }
+}
+
+guint sf_section_begin(GByteArray *buf, savefile_section type)
+{
+    sf_put_u8(buf, type);
+
+    /* placeholders for the payload size and checksum */
+    guint offset = buf->len;
+    sf_put_u32(buf, 0);
+    sf_put_u32(buf, 0);
+
+    return offset;
+}
+
+void sf_section_end(GByteArray *buf, guint offset)
+{
+    g_assert(offset + 8 <= buf->len);
+
+    guint32 len = buf->len - offset - 8;
+    guint32 crc = crc32(0, buf->data + offset + 8, len);
+
+    for (int idx = 0; idx < 4; idx++)
+    {
+        buf->data[offset + idx]     = (len >> (8 * idx)) & 0xff;
+        buf->data[offset + 4 + idx] = (crc >> (8 * idx)) & 0xff;
+    }
+}
+
+GByteArray *sf_compress(const guint8 *data, gsize len, int level)
+{
+    z_stream zs;
+    int ret;
+
+    if (level == 0)
+    {
+        /* store uncompressed */
+        GByteArray *out = g_byte_array_sized_new(len);
+        g_byte_array_append(out, data, len);
+
+        return out;
+    }
+
+    memset(&zs, 0, sizeof(zs));
+
+    /* adding 16 to the window bits produces a gzip wrapper */
+    if (deflateInit2(&zs, level, Z_DEFLATED, 15 + 16, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK)
+        return NULL;
+
+    GByteArray *out = g_byte_array_sized_new(0);
+    g_byte_array_set_size(out, deflateBound(&zs, len));
+
+    zs.next_in = (Bytef *)data;
+    zs.avail_in = len;
+    zs.next_out = out->data;
+    zs.avail_out = out->len;
+
+    ret = deflate(&zs, Z_FINISH);
+    deflateEnd(&zs);
+
+    if (ret != Z_STREAM_END)
+    {
+        g_byte_array_free(out, TRUE);
+        return NULL;
+    }
+
+    g_byte_array_set_size(out, zs.total_out);
+
+    return out;
+}
+
+void sf_reader_init(savefile_reader *r, gconstpointer data, gsize len)
+{
+    r->data = data;
+    r->len = len;
+    r->pos = 0;
+    r->error = FALSE;
+}
+
+const guint8 *sf_get_data(savefile_reader *r, gsize len)
+{
+    if (r->error || (r->len - r->pos) < len)
+    {
+        /* do not try to read anything after running out of data once */
+        r->error = TRUE;
+        return NULL;
+    }
+
+    const guint8 *data = r->data + r->pos;
+    r->pos += len;
+
+    return data;
+}
+
+guint8 sf_get_u8(savefile_reader *r)
+{
+    const guint8 *d = sf_get_data(r, 1);
+    return (d != NULL) ? d[0] : 0;
+}
+
+guint16 sf_get_u16(savefile_reader *r)
+{
+    const guint8 *d = sf_get_data(r, 2);
+    return (d != NULL) ? (d[0] | d[1] << 8) : 0;
+}
+
+guint32 sf_get_u32(savefile_reader *r)
+{
+    const guint8 *d = sf_get_data(r, 4);
+
+    if (d == NULL)
+        return 0;
+
+    return d[0] | d[1] << 8 | d[2] << 16 | (guint32)d[3] << 24;
+}
+
+gboolean sf_get_rle(savefile_reader *r, guint32 *values, guint count,
+                    guint width)
+{
+    for (guint idx = 0; idx < count; )
+    {
+        guint run = sf_get_u16(r);
+        guint32 val = (width == 1) ? sf_get_u8(r) : sf_get_u32(r);
+
+        if (r->error || run == 0 || idx + run > count)
+            return FALSE;
+
+        while (run--)
+            values[idx++] = val;
+    }
+
+    return TRUE;
+}
+
+gboolean sf_is_binary(gconstpointer data, gsize len)
+{
+    return (len >= SAVEFILE_HEADER_LEN)
+        && (memcmp(data, SAVEFILE_MAGIC, SAVEFILE_MAGIC_LEN) == 0);
+}
+
+gboolean sf_stream_section(savefile_stream *s, savefile_section type,
+                           savefile_reader *section)
+{
+    guint8 header[SAVEFILE_SECTION_LEN];
+    savefile_reader r;
+
+    /* older revisions have no checksum */
+    const int hlen = (s->format >= 4) ? SAVEFILE_SECTION_LEN
+                                      : SAVEFILE_SECTION_LEN_3;
+
+    if (gzread(s->file, header, hlen) != hlen)
+        return FALSE;
+
+    sf_reader_init(&r, header, hlen);
+    guint8 stype = sf_get_u8(&r);
+    guint32 len = sf_get_u32(&r);
+    guint32 crc = sf_get_u32(&r);
+
+    if (stype != type || len > SAVEFILE_SECTION_MAX)
+        return FALSE;
+
+    /* the buffer is reused for every section */
+    g_byte_array_set_size(s->buf, len);
+
+    if (len > 0 && gzread(s->file, s->buf->data, len) != (int)len)
+        return FALSE;
+
+    /* a corrupted payload must not reach the decoders */
+    if (s->format >= 4 && crc32(0, s->buf->data, len) != crc)
+        return FALSE;
+
+    sf_reader_init(section, s->buf->data, len);
+
+    return TRUE;
+}
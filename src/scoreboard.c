@@ -75,15 +75,23 @@ GList *scores_load()
     /* count of buffer allocations */
     gint bufcount = 1;
 
+    /* count of bytes read */
+    gint len, total = 0;
+
     /* read the scoreboard file
      * append subsequent blocks at the end of the previously read block */
-    while(gzread(file, scores + ((bufcount - 1) * bufsize), bufsize) == bufsize)
+    while((len = gzread(file, scores + total, bufsize)) == bufsize)
     {
         /* it seems the buffer space was insufficient -> increase it */
+        total += len;
         bufcount += 1;
         scores = g_realloc(scores, (bufsize * bufcount));
     }
 
+    /* the last block is never full, leaving space for the terminator */
+    if (len > 0) total += len;
+    scores[total] = '\0';
+
 #if ((defined (__unix) || defined (__unix__)) && defined (SETGID))
     /* reposition to the start otherwise writing would append */
     gzrewind(file);
@@ -94,10 +102,11 @@ GList *scores_load()
     /* parsed scoreboard; scoreboard entry */
     cJSON *pscores, *s_entry;
 
-    /* parse the scores */
-    if ((pscores = cJSON_Parse(scores)) == NULL)
+    /* parse the scores; the strings stay in the buffer read from the file */
+    if ((pscores = cJSON_ParseInSitu(scores)) == NULL)
     {
         /* empty file, no entries */
+        g_free(scores);
         return gs;
     }
 
@@ -187,13 +196,19 @@ static void scores_save(game *g, GList *gs)
     char *uscores = cJSON_PrintUnformatted(sf);
     cJSON_Delete(sf);
 
-    /* open the file for writing */
+    /* open the file for writing; "T" writes the file uncompressed */
+    char *mode = (g->compression == 0)
+        ? g_strdup("wbT")
+        : g_strdup_printf("wb%d", g->compression);
+
 #if ((defined (__unix) || defined (__unix__)) && defined (SETGID))
-    gzFile sb = gzdopen(scoreboard_fd, "wb");
+    gzFile sb = gzdopen(scoreboard_fd, mode);
 #else
-    gzFile sb = gzopen(nlarn->highscores, "wb");
+    gzFile sb = gzopen(nlarn->highscores, mode);
 #endif
 
+    g_free(mode);
+
     if (sb == NULL)
     {
         /* opening the file failed */
@@ -1043,6 +1043,7 @@ static gboolean spell_alter_reality(spell *s, player *p)
     /* reset the player's memory of the current map */
     memset(&player_memory_of(p, pos), 0,
            MAP_MAX_Y * MAP_MAX_X * sizeof(player_tile_memory));
+    fov_reset(p->fv);
 
     map_destroy(game_map(nlarn, Z(p->pos)));
 
@@ -1289,6 +1290,7 @@ static gboolean spell_make_wall(spell *s __attribute__((unused)), player *p)
         log_add_entry(nlarn->log, "You have created a wall.");
 
         tile->type = tile->base_type = LT_WALL;
+        map_tile_changed(pmap, pos);
 
         monster *m;
         if ((m = map_get_monster_at(pmap, pos)))
@@ -1593,6 +1595,7 @@ static int try_drying_ground(position pos)
         }
 
         tile->type = LT_WATER;
+        map_tile_changed(game_map(nlarn, Z(pos)), pos);
         log_add_entry(nlarn->log, "The water is more shallow now.");
         return TRUE;
     }
@@ -1611,6 +1614,8 @@ static int try_drying_ground(position pos)
         else
             tile->type = tile->base_type;
 
+        map_tile_changed(game_map(nlarn, Z(pos)), pos);
+
         if (tile->timer)
             tile->timer = 0;
 